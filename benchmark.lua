@@ -0,0 +1,45 @@
+-- Render benchmark, run: otclient --headless --benchmark <record file> <client version> [seconds]
+-- plays a recorded session, saves the timings of every frame to benchmark.csv and prints a summary
+local options = g_app.getStartupOptions():split(" ")
+local record, version, seconds
+for i, option in ipairs(options) do
+  if option == "--benchmark" then
+    record = options[i + 1]
+    version = tonumber(options[i + 2])
+    seconds = tonumber(options[i + 3]) or 30
+  end
+end
+
+if not record or not version then
+  g_logger.fatal("Usage: --benchmark <record file> <client version> [seconds]")
+end
+
+scheduleEvent(function()
+  EnterGame.hide()
+  g_settings.setNode("things", {})
+  g_game.setClientVersion(version)
+  g_game.setProtocolVersion(g_game.getClientProtocolVersion(version))
+  g_game.playRecord(record)
+end, 1000)
+
+-- let the record log in and load the map before measuring
+scheduleEvent(function()
+  if not g_game.isOnline() then
+    g_logger.fatal("[BENCHMARK] Unable to play record " .. record)
+  end
+  g_logger.info("[BENCHMARK] Measuring " .. seconds .. " seconds of " .. record)
+  g_app.startBenchmark()
+end, 5000)
+
+scheduleEvent(function()
+  local result = g_app.stopBenchmark("benchmark.csv")
+  local names = {}
+  for name in pairs(result) do
+    table.insert(names, name)
+  end
+  table.sort(names)
+  for _, name in ipairs(names) do
+    g_logger.info(string.format("[BENCHMARK] %s: %.3f", name, result[name]))
+  end
+  g_app.exit()
+end, 5000 + seconds * 1000)
@@ -86,6 +86,14 @@ local function validateThings(things)
   local versionForMissingFiles = 0
   if things ~= nil then
     local thingsNode = {}
+    local paths = {}
+    for thingtype, thingdata in pairs(things) do
+      if g_resources.fileExists("/things/" .. thingdata[1]) then
+        table.insert(paths, "/things/" .. thingdata[1])
+      end
+    end
+    -- one batch, so the checksums cache is written once
+    local checksums = g_resources.fileChecksums(paths)
     for thingtype, thingdata in pairs(things) do
       thingsNode[thingtype] = thingdata[1]
       if not g_resources.fileExists("/things/" .. thingdata[1]) then
@@ -93,7 +101,7 @@ local function validateThings(things)
         missingFiles = true
         versionForMissingFiles = thingdata[1]:split("/")[1]
       else
-        local localChecksum = g_resources.fileChecksum("/things/" .. thingdata[1]):lower()
+        local localChecksum = checksums["/things/" .. thingdata[1]]:lower()
         if localChecksum ~= thingdata[2]:lower() and #thingdata[2] > 1 then
           if g_resources.isLoadedFromArchive() then -- ignore checksum if it's test/debug version
             incorrectThings = incorrectThings .. "Invalid checksum of file: " .. thingdata[1] .. " (is " .. localChecksum .. ", should be " .. thingdata[2]:lower() .. ")\n"
@@ -82,6 +82,7 @@ private:
     bool m_isComplete;
 
     int m_phase;
+    std::mutex m_mutex; // animators are shared by every thing of a type, which may be drawn from two threads
 };
 
 #endif
@@ -76,6 +76,9 @@ Creature::Creature() : Thing()
 
 Creature::~Creature()
 {
+    int attachedWidgets = m_topWidgets.size() + m_bottomWidgets.size() + m_directionalWidgets.size();
+    if (attachedWidgets > 0)
+        updateAttachedWidgets(-attachedWidgets);
     g_stats.removeCreature();
 }
 
@@ -133,13 +136,20 @@ void Creature::drawOutfit(const Rect& destRect, Otc::Direction direction, const
     m_outfit.draw(destRect, direction, 0, animate, ui, oldScaling);
 }
 
-void Creature::drawInformation(const Point& point, bool useGray, const Rect& parentRect, int drawFlags)
+void Creature::layoutInformation(InformationLayout& layout, const Point& point, bool useGray, const Rect& parentRect, int drawFlags, bool iconsBelowBars)
 {
+    layout.visible = false;
     if (!g_game.getFeature(Otc::GameOldInformationBar) && g_game.getClientVersion() >= 760) {
         if (m_healthPercent < 1)  // creature is dead, we get rid of its information bar
             return;
     }
 
+    layout.visible = true;
+    layout.point = point;
+    layout.drawFlags = drawFlags;
+    layout.drawMana = false;
+    layout.drawProgress = false;
+
     Color fillColor = Color(96, 96, 96);
 
     if (!useGray)
@@ -196,19 +206,17 @@ void Creature::drawInformation(const Point& point, bool useGray, const Rect& par
     Rect healthRect = backgroundRect.expanded(-1);
     healthRect.setWidth((m_healthPercent / 100.0) * 25);
 
-    // draw
     if (g_game.getFeature(Otc::GameBlueNpcNameColor) && isNpc() && m_healthPercent == 100 && !useGray)
         fillColor = Color(0x66, 0xcc, 0xff);
 
-    if (drawFlags & Otc::DrawBars && (!isNpc() || !g_game.getFeature(Otc::GameHideNpcNames))) {
-        if (healthBar) {
-            TexturePtr barTexture = healthBar->getTexture();
-            Rect barRect = Rect(backgroundRect.x() + healthBar->getOffset().x, backgroundRect.y() + healthBar->getOffset().y, barTexture->getSize());
-            g_drawQueue->addTexturedRect(barRect, barTexture, Rect(0, 0, barTexture->getSize()));
-        }
-        g_drawQueue->addFilledRect(backgroundRect, Color::black);
-        g_drawQueue->addFilledRect(healthRect, fillColor);
+    layout.textRect = textRect;
+    layout.backgroundRect = backgroundRect;
+    layout.healthRect = healthRect;
+    layout.fillColor = fillColor;
+    layout.healthBar = healthBar;
+    layout.manaBar = nullptr;
 
+    if (drawFlags & Otc::DrawBars && (!isNpc() || !g_game.getFeature(Otc::GameHideNpcNames))) {
         if (drawFlags & Otc::DrawManaBar) {
             int8 manaPercent = m_manaPercent;
             if (isLocalPlayer()) {
@@ -234,71 +242,106 @@ void Creature::drawInformation(const Point& point, bool useGray, const Rect& par
                     backgroundRect.setHeight(manaBar->getHeight());
                     backgroundRect.moveTop(backgroundRect.top() + manaBar->getBarOffset().y);
                     backgroundRect.moveLeft(backgroundRect.left() + manaBar->getBarOffset().x);
-
-                    TexturePtr barTexture = manaBar->getTexture();
-                    Rect barRect = Rect(backgroundRect.x() + manaBar->getOffset().x, backgroundRect.y() + manaBar->getOffset().y, barTexture->getSize());
-                    g_drawQueue->addTexturedRect(barRect, barTexture, Rect(0, 0, barTexture->getSize()));
                 }
-                g_drawQueue->addFilledRect(backgroundRect, Color::black);
 
                 Rect manaRect = backgroundRect.expanded(-1);
                 manaRect.setWidth(((float)manaPercent / 100.f) * 25);
-                g_drawQueue->addFilledRect(manaRect, Color::blue);
+
+                layout.drawMana = true;
+                layout.manaBar = manaBar;
+                layout.manaBackgroundRect = backgroundRect;
+                layout.manaRect = manaRect;
             }
         }
 
         if (getProgressBarPercent()) {
             backgroundRect.moveTop(backgroundRect.bottom());
 
-            g_drawQueue->addFilledRect(backgroundRect, Color::black);
-
             Rect progressBarRect = backgroundRect.expanded(-1);
             double maxBar = 100;
             progressBarRect.setWidth(getProgressBarPercent() / (maxBar * 1.0) * 25);
 
-            g_drawQueue->addFilledRect(progressBarRect, Color::white);
+            layout.drawProgress = true;
+            layout.progressBackgroundRect = backgroundRect;
+            layout.progressRect = progressBarRect;
         }
     }
 
-    if (drawFlags & Otc::DrawNames) {
-        m_nameCache.draw(textRect, fillColor);
+    layout.iconsRect = iconsBelowBars ? backgroundRect : layout.backgroundRect;
+}
+
+void Creature::drawInformation(const InformationLayout& layout, int parts)
+{
+    if (!layout.visible)
+        return;
+
+    int drawFlags = layout.drawFlags;
+    if (parts & InformationBars && drawFlags & Otc::DrawBars && (!isNpc() || !g_game.getFeature(Otc::GameHideNpcNames))) {
+        if (layout.healthBar) {
+            TexturePtr barTexture = layout.healthBar->getTexture();
+            Rect barRect = Rect(layout.backgroundRect.x() + layout.healthBar->getOffset().x, layout.backgroundRect.y() + layout.healthBar->getOffset().y, barTexture->getSize());
+            g_drawQueue->addTexturedRect(barRect, barTexture, Rect(0, 0, barTexture->getSize()));
+        }
+        g_drawQueue->addFilledRect(layout.backgroundRect, Color::black);
+        g_drawQueue->addFilledRect(layout.healthRect, layout.fillColor);
+
+        if (layout.drawMana) {
+            if (layout.manaBar) {
+                TexturePtr barTexture = layout.manaBar->getTexture();
+                Rect barRect = Rect(layout.manaBackgroundRect.x() + layout.manaBar->getOffset().x, layout.manaBackgroundRect.y() + layout.manaBar->getOffset().y, barTexture->getSize());
+                g_drawQueue->addTexturedRect(barRect, barTexture, Rect(0, 0, barTexture->getSize()));
+            }
+            g_drawQueue->addFilledRect(layout.manaBackgroundRect, Color::black);
+            g_drawQueue->addFilledRect(layout.manaRect, Color::blue);
+        }
+
+        if (layout.drawProgress) {
+            g_drawQueue->addFilledRect(layout.progressBackgroundRect, Color::black);
+            g_drawQueue->addFilledRect(layout.progressRect, Color::white);
+        }
+    }
+
+    if (parts & InformationNames && drawFlags & Otc::DrawNames) {
+        m_nameCache.draw(layout.textRect, layout.fillColor);
 
         if (m_titleCache.hasText()) {
             Size titleSize = m_titleCache.getTextSize();
-            Point textCenter = textRect.topCenter();
-            textRect.setSize(titleSize);
-            textRect.moveBottomCenter(textCenter);
-            m_titleCache.draw(textRect, m_titleColor);
+            Rect titleRect = layout.textRect;
+            Point textCenter = titleRect.topCenter();
+            titleRect.setSize(titleSize);
+            titleRect.moveBottomCenter(textCenter);
+            m_titleCache.draw(titleRect, m_titleColor);
         }
 
         if (m_text) {
             auto extraTextSize = m_text->getCachedText().getTextSize();
-            Rect extraTextRect = Rect(point.x + m_informationOffset.x - extraTextSize.width() / 2.0, point.y + m_informationOffset.y + 15, extraTextSize);
+            Rect extraTextRect = Rect(layout.point.x + m_informationOffset.x - extraTextSize.width() / 2.0, layout.point.y + m_informationOffset.y + 15, extraTextSize);
             m_text->drawText(extraTextRect.center(), extraTextRect);
         }
     }
 
-    if (!(drawFlags & Otc::DrawIcons))
+    if (!(parts & InformationIcons) || !(drawFlags & Otc::DrawIcons))
         return;
 
+    const Rect& iconsRect = layout.iconsRect;
     if (m_skull != Otc::SkullNone && m_skullTexture) {
-        Rect skullRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 5, m_skullTexture->getSize());
+        Rect skullRect = Rect(iconsRect.x() + 13.5 + 12, iconsRect.y() + 5, m_skullTexture->getSize());
         g_drawQueue->addTexturedRect(skullRect, m_skullTexture, Rect(0, 0, m_skullTexture->getSize()));
     }
     if (m_shield != Otc::ShieldNone && m_shieldTexture && m_showShieldTexture) {
-        Rect shieldRect = Rect(backgroundRect.x() + 13.5, backgroundRect.y() + 5, m_shieldTexture->getSize());
+        Rect shieldRect = Rect(iconsRect.x() + 13.5, iconsRect.y() + 5, m_shieldTexture->getSize());
         g_drawQueue->addTexturedRect(shieldRect, m_shieldTexture, Rect(0, 0, m_shieldTexture->getSize()));
     }
     if (m_emblem != Otc::EmblemNone && m_emblemTexture) {
-        Rect emblemRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 16, m_emblemTexture->getSize());
+        Rect emblemRect = Rect(iconsRect.x() + 13.5 + 12, iconsRect.y() + 16, m_emblemTexture->getSize());
         g_drawQueue->addTexturedRect(emblemRect, m_emblemTexture, Rect(0, 0, m_emblemTexture->getSize()));
     }
     if (m_type != Proto::CreatureTypeUnknown && m_typeTexture) {
-        Rect typeRect = Rect(backgroundRect.x() + 13.5 + 12 + 12, backgroundRect.y() + 16, m_typeTexture->getSize());
+        Rect typeRect = Rect(iconsRect.x() + 13.5 + 12 + 12, iconsRect.y() + 16, m_typeTexture->getSize());
         g_drawQueue->addTexturedRect(typeRect, m_typeTexture, Rect(0, 0, m_typeTexture->getSize()));
     }
     if (m_icon != Otc::NpcIconNone && m_iconTexture) {
-        Rect iconRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 5, m_iconTexture->getSize());
+        Rect iconRect = Rect(iconsRect.x() + 13.5 + 12, iconsRect.y() + 5, m_iconTexture->getSize());
         g_drawQueue->addTexturedRect(iconRect, m_iconTexture, Rect(0, 0, m_iconTexture->getSize()));
     }
 }
@@ -1037,11 +1080,22 @@ std::string Creature::getText()
 
 
 // widgets
+std::atomic<int> Creature::s_attachedWidgets(0);
+
+void Creature::updateAttachedWidgets(int delta)
+{
+    // attached widgets are laid out while the map is drawn and may call lua,
+    // so while any exist the map has to be built on the dispatcher thread
+    s_attachedWidgets += delta;
+    g_app.setMapPassThreadSafe(s_attachedWidgets == 0);
+}
+
 void Creature::addTopWidget(const UIWidgetPtr& widget)
 {
     if (!widget) return;
     if (std::find(m_topWidgets.begin(), m_topWidgets.end(), widget) == m_topWidgets.end()) {
         m_topWidgets.push_back(widget);
+        updateAttachedWidgets(1);
     }
 }
 
@@ -1050,6 +1104,7 @@ void Creature::addBottomWidget(const UIWidgetPtr& widget)
     if (!widget) return;
     if (std::find(m_bottomWidgets.begin(), m_bottomWidgets.end(), widget) == m_bottomWidgets.end()) {
         m_bottomWidgets.push_back(widget);
+        updateAttachedWidgets(1);
     }
 }
 
@@ -1058,35 +1113,38 @@ void Creature::addDirectionalWidget(const UIWidgetPtr& widget)
     if (!widget) return;
     if (std::find(m_directionalWidgets.begin(), m_directionalWidgets.end(), widget) == m_directionalWidgets.end()) {
         m_directionalWidgets.push_back(widget);
+        updateAttachedWidgets(1);
     }
 }
 
 void Creature::removeTopWidget(const UIWidgetPtr& widget)
 {
-    auto it = std::remove(m_topWidgets.begin(), m_topWidgets.end(), widget);
-    while(it != m_topWidgets.end()) {
-        (*it)->destroy();
-        it = m_topWidgets.erase(it);
-    }
+    auto it = std::find(m_topWidgets.begin(), m_topWidgets.end(), widget);
+    if (it == m_topWidgets.end())
+        return;
+    (*it)->destroy();
+    m_topWidgets.erase(it);
+    updateAttachedWidgets(-1);
 }
 
 void Creature::removeBottomWidget(const UIWidgetPtr& widget)
 {
-    auto it = std::remove(m_bottomWidgets.begin(), m_bottomWidgets.end(), widget);
-    while (it != m_topWidgets.end()) {
-        (*it)->destroy();
-        it = m_bottomWidgets.erase(it);
-    }
+    auto it = std::find(m_bottomWidgets.begin(), m_bottomWidgets.end(), widget);
+    if (it == m_bottomWidgets.end())
+        return;
+    (*it)->destroy();
+    m_bottomWidgets.erase(it);
+    updateAttachedWidgets(-1);
 }
 
 void Creature::removeDirectionalWidget(const UIWidgetPtr& widget)
-{    
-    auto it = m_directionalWidgets.erase(std::remove(m_directionalWidgets.begin(), m_directionalWidgets.end(), widget));
-    while (it != m_topWidgets.end()) {
-        (*it)->destroy();
-        it = m_directionalWidgets.erase(it);
-    }
-
+{
+    auto it = std::find(m_directionalWidgets.begin(), m_directionalWidgets.end(), widget);
+    if (it == m_directionalWidgets.end())
+        return;
+    (*it)->destroy();
+    m_directionalWidgets.erase(it);
+    updateAttachedWidgets(-1);
 }
 
 std::list<UIWidgetPtr> Creature::getTopWidgets()
@@ -1116,6 +1174,7 @@ void Creature::clearTopWidgets()
     for (auto& widget : m_topWidgets) {
         widget->destroy();
     }
+    updateAttachedWidgets(-(int)m_topWidgets.size());
     m_topWidgets.clear();
 }
 
@@ -1124,6 +1183,7 @@ void Creature::clearBottomWidgets()
     for (auto& widget : m_bottomWidgets) {
         widget->destroy();
     }
+    updateAttachedWidgets(-(int)m_bottomWidgets.size());
     m_bottomWidgets.clear();
 }
 
@@ -1132,6 +1192,7 @@ void Creature::clearDirectionalWidgets()
     for (auto& widget : m_directionalWidgets) {
         widget->destroy();
     }
+    updateAttachedWidgets(-(int)m_directionalWidgets.size());
     m_directionalWidgets.clear();
 }
 
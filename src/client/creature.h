@@ -43,13 +43,43 @@ public:
         VOLATILE_SQUARE_DURATION = 1000
     };
 
+    // parts of the information drawn by one drawInformation call, all parts are drawn from the same layout
+    // so the map can draw the bars, the names and the icons of all creatures in separate passes
+    enum InformationPart {
+        InformationBars = 1,
+        InformationNames = 2,
+        InformationIcons = 4,
+        InformationAll = InformationBars | InformationNames | InformationIcons
+    };
+
+    // rects of the information above a creature, computed once per frame by layoutInformation
+    struct InformationLayout {
+        Point point;
+        Rect textRect;
+        Rect backgroundRect;
+        Rect healthRect;
+        Rect manaBackgroundRect;
+        Rect manaRect;
+        Rect progressBackgroundRect;
+        Rect progressRect;
+        Rect iconsRect; // icons are placed relative to it
+        Color fillColor;
+        HealthBarPtr healthBar;
+        HealthBarPtr manaBar;
+        int drawFlags = 0;
+        bool visible = false;
+        bool drawMana = false;
+        bool drawProgress = false;
+    };
+
     Creature();
     virtual ~Creature();
 
     virtual void draw(const Point& dest, bool animate = true, LightView* lightView = nullptr);
     virtual void drawOutfit(const Rect& destRect, Otc::Direction direction = Otc::InvalidDirection, const Color& color = Color::white, bool animate = false, bool ui = false, bool oldScaling = false);
 
-    void drawInformation(const Point& point, bool useGray, const Rect& parentRect, int drawFlags);
+    void layoutInformation(InformationLayout& layout, const Point& point, bool useGray, const Rect& parentRect, int drawFlags, bool iconsBelowBars = true);
+    void drawInformation(const InformationLayout& layout, int parts = InformationAll);
 
     bool isInsideOffset(Point offset);
 
@@ -284,6 +314,8 @@ protected:
     std::list<UIWidgetPtr> m_bottomWidgets;
     std::list<UIWidgetPtr> m_directionalWidgets;
     std::list<UIWidgetPtr> m_topWidgets;
+    static std::atomic<int> s_attachedWidgets;
+    static void updateAttachedWidgets(int delta);
 
     // progress bar
     uint8 m_progressBarPercent;
@@ -23,6 +23,7 @@
 #include "lightview.h"
 #include "spritemanager.h"
 #include <framework/graphics/painter.h>
+#include <framework/core/adaptiverenderer.h>
 
 void LightView::addLight(const Point& pos, uint8_t color, uint8_t intensity)
 {
@@ -33,6 +34,8 @@ void LightView::addLight(const Point& pos, uint8_t color, uint8_t intensity)
             return;
         }
     }
+    if (m_lights.size() >= m_maxLights)
+        return;
     m_lights.push_back(Light{ pos, color, intensity });
 }
 
@@ -46,6 +49,7 @@ void LightView::setFieldBrightness(const Point& pos, size_t start, uint8_t color
 
 void LightView::draw() // render thread
 {
+    ticks_t start = stdext::micros();
     // TODO: optimize in the future for big areas
     static std::vector<uint8_t> buffer;
     if (buffer.size() < 4u * m_mapSize.area())
@@ -76,9 +80,7 @@ void LightView::draw() // render thread
         }
     }
 
-    m_lightTexture->update();
-    glBindTexture(GL_TEXTURE_2D, m_lightTexture->getId());
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_mapSize.width(), m_mapSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+    m_lightTexture->updatePixels(Rect(Point(0, 0), m_mapSize), buffer.data());
 
     Point offset = m_src.topLeft();
     Size size = m_src.size();
@@ -91,4 +93,5 @@ void LightView::draw() // render thread
     g_painter->setCompositionMode(Painter::CompositionMode_Multiply);
     g_painter->drawTextureCoords(coords, m_lightTexture);
     g_painter->resetCompositionMode();
+    g_adaptiveRenderer.addPhaseTime(AdaptiveRenderer::PhaseLights, stdext::micros() - start);
 }
@@ -37,8 +37,8 @@ struct TileLight {
 class LightView : public DrawQueueItem
 {
 public:
-    LightView(TexturePtr& lightTexture, const Size& mapSize, const Rect& dest, const Rect& src, uint8_t color, uint8_t intensity) :
-        DrawQueueItem(nullptr), m_lightTexture(lightTexture), m_mapSize(mapSize), m_dest(dest), m_src(src) {
+    LightView(TexturePtr& lightTexture, const Size& mapSize, const Rect& dest, const Rect& src, uint8_t color, uint8_t intensity, size_t maxLights) :
+        DrawQueueItem(nullptr), m_lightTexture(lightTexture), m_mapSize(mapSize), m_dest(dest), m_src(src), m_maxLights(maxLights) {
         m_globalLight = Color::from8bit(color) * ((float)intensity / 255.f);
         m_tiles.resize(m_mapSize.area(), TileLight{ 0, 0 });
     }
@@ -52,6 +52,7 @@ public:
     size_t size() { return m_lights.size(); }
 
     void draw() override;
+    bool overlay() override { return true; }
 
 private:
     TexturePtr m_lightTexture;
@@ -59,6 +60,7 @@ private:
     Rect m_dest, m_src;
     Color m_globalLight;
     std::vector<Light> m_lights;
+    size_t m_maxLights; // lights after the limit are ignored, every light costs a pass over the whole view
     std::vector<TileLight> m_tiles;
 };
 
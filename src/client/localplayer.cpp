@@ -168,8 +168,6 @@ void LocalPlayer::preWalk(Otc::Direction direction)
 
     m_lastPrewalkDone = false;
     m_preWalking.push_back(newPos);
-    if (m_preWalking.size() > 1)
-        g_map.requestVisibleTilesCacheUpdate();
 
     Creature::walk(startPos, newPos);
 }
@@ -183,7 +181,6 @@ void LocalPlayer::cancelNewWalk(Otc::Direction dir)
     bool clearedPrewalk = !m_preWalking.empty();
 
     m_preWalking.clear();
-    g_map.requestVisibleTilesCacheUpdate();
 
     if (clearedPrewalk) {
         stopWalk();
@@ -226,7 +223,6 @@ bool LocalPlayer::predictiveCancelWalk(const Position& pos, uint32_t predictionI
         m_walkTimer.restart();
         m_walkTimer.adjust(-(getStepDuration(true) + 50));
         updateWalk();
-        g_map.requestVisibleTilesCacheUpdate();
 
         return true;
     }
@@ -89,6 +89,7 @@ void Map::clean()
 
     for(int i=0;i<=Otc::MAX_Z;++i)
         m_tileBlocks[i].clear();
+    requestVisibleTilesCacheUpdate();
 
     m_waypoints.clear();
 
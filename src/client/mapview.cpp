@@ -108,10 +108,10 @@ void MapView::drawTileWidget(const Rect& rect, const Rect& srcRect)
 }
 
 void MapView::drawMapBackground(const Rect& rect, const TilePtr& crosshairTile) {
+    ticks_t start = stdext::micros();
+    m_creaturesTime = 0;
     Position cameraPosition = getCameraPosition();
-    if (m_mustUpdateVisibleTilesCache) {
-        updateVisibleTilesCache();
-    }
+    updateVisibleTilesCache();
 
     if (g_game.getFeature(Otc::GameForceLight)) {
         m_drawLight = true;
@@ -120,6 +120,8 @@ void MapView::drawMapBackground(const Rect& rect, const TilePtr& crosshairTile)
 
     Rect srcRect = calcFramebufferSource(rect.size());
     g_drawQueue->setFrameBuffer(rect, m_optimizedSize, srcRect);
+    if (cameraPosition.isValid())
+        g_drawQueue->setFrameBufferScroll(Point(cameraPosition.x, cameraPosition.y) * g_sprites.spriteSize(), g_sprites.spriteSize());
 
     if (m_drawLight) {
         Light ambientLight;
@@ -128,9 +130,11 @@ void MapView::drawMapBackground(const Rect& rect, const TilePtr& crosshairTile)
         if (!m_lightTexture || m_lightTexture->getSize() != m_drawDimension)
             m_lightTexture = TexturePtr(new Texture(m_drawDimension, false, true));
         m_lightView = std::make_unique<LightView>(m_lightTexture, m_drawDimension, rect, srcRect, ambientLight.color,
-                                                  std::max<int>(m_minimumAmbientLight * 255, ambientLight.intensity));
+                                                  std::max<int>(m_minimumAmbientLight * 255, ambientLight.intensity), g_adaptiveRenderer.lightsLimit());
     }
 
+    updateOcclusion(cameraPosition);
+
     for (int z = m_cachedLastVisibleFloor; z >= m_cachedFirstFadingFloor; --z) {
         float fading = 1.0;
         if (m_floorFading > 0) {
@@ -150,6 +154,19 @@ void MapView::drawMapBackground(const Rect& rect, const TilePtr& crosshairTile)
             g_drawQueue->setOpacity(floorStart, fading);
     }
 
+    if (g_extras.debugOcclusion) {
+        for (int z = m_cachedLastVisibleFloor; z >= m_cachedFirstVisibleFloor; --z) {
+            for (auto& tile : m_cachedVisibleTiles[z]) {
+                if (!isOccluded(tile, cameraPosition))
+                    continue;
+                Point tileDrawPos = transformPositionTo2D(tile->getPosition(), cameraPosition);
+                g_drawQueue->addFilledRect(Rect(tileDrawPos, Size(g_sprites.spriteSize(), g_sprites.spriteSize())), Color(255, 0, 0, 48));
+            }
+        }
+    }
+
+    g_adaptiveRenderer.addPhaseTime(AdaptiveRenderer::PhaseCreatures, m_creaturesTime);
+    g_adaptiveRenderer.addPhaseTime(AdaptiveRenderer::PhaseMap, stdext::micros() - start - m_creaturesTime);
 } 
 
 void MapView::drawFloor(short floor, const Position& cameraPosition, const TilePtr& crosshairTile)
@@ -163,6 +180,8 @@ void MapView::drawFloor(short floor, const Position& cameraPosition, const TileP
     // light
     if (m_lightView) {
         for (auto& tile : tiles) {
+            if (isOccluded(tile, cameraPosition))
+                continue;
             Point tileDrawPos = transformPositionTo2D(tile->getPosition(), cameraPosition);
             ItemPtr ground = tile->getGround();
             if (ground && ground->isGround() && !ground->isTranslucent()) {
@@ -174,11 +193,15 @@ void MapView::drawFloor(short floor, const Position& cameraPosition, const TileP
     if (g_game.getFeature(Otc::GameMapDrawGroundFirst)) {
         // ground
         for (auto& tile : tiles) {
+            if (isOccluded(tile, cameraPosition))
+                continue;
             Point tileDrawPos = transformPositionTo2D(tile->getPosition(), cameraPosition);
             tile->drawGround(tileDrawPos, m_lightView.get());
         }
         // bottom, creatures, top
         for (auto& tile : tiles) {
+            if (isOccluded(tile, cameraPosition))
+                continue;
             Point tileDrawPos = transformPositionTo2D(tile->getPosition(), cameraPosition);
 
             tile->drawBottom(tileDrawPos, m_lightView.get());
@@ -188,12 +211,16 @@ void MapView::drawFloor(short floor, const Position& cameraPosition, const TileP
                                              m_crosshair, Rect(0, 0, m_crosshair->getSize()));
             }
 
+            ticks_t creaturesStart = stdext::micros();
             tile->drawCreatures(tileDrawPos, m_lightView.get());
+            m_creaturesTime += stdext::micros() - creaturesStart;
             tile->drawTop(tileDrawPos, m_lightView.get());
         }
     } else {
         // ground, bottom, creatures, top
         for (auto& tile : tiles) {
+            if (isOccluded(tile, cameraPosition))
+                continue;
             Point tileDrawPos = transformPositionTo2D(tile->getPosition(), cameraPosition);
 
             if (m_lightView) {
@@ -212,7 +239,9 @@ void MapView::drawFloor(short floor, const Position& cameraPosition, const TileP
                                              m_crosshair, Rect(0, 0, m_crosshair->getSize()));
             }
 
+            ticks_t creaturesStart = stdext::micros();
             tile->drawCreatures(tileDrawPos, m_lightView.get());
+            m_creaturesTime += stdext::micros() - creaturesStart;
             tile->drawTop(tileDrawPos, m_lightView.get());
         }
     }
@@ -230,13 +259,21 @@ void MapView::drawMapForeground(const Rect& rect)
     if (!cameraPosition.isValid())
         return;
 
+    // names, bars and texts are all measured as the texts phase
+    ticks_t start = stdext::micros();
     Rect srcRect = calcFramebufferSource(rect.size());
     Point drawOffset = srcRect.topLeft();
     float horizontalStretchFactor = rect.width() / (float)srcRect.width();
     float verticalStretchFactor = rect.height() / (float)srcRect.height();
 
-    // creatures
-    std::vector<std::pair<CreaturePtr, Point>> creatures;
+    // creatures, the covered state is checked once and shared by every information pass
+    struct CreatureInformation {
+        CreaturePtr creature;
+        Point point;
+        bool covered;
+        Creature::InformationLayout layout;
+    };
+    std::vector<CreatureInformation> creatures;
     for (const CreaturePtr& creature : g_map.getSpectatorsInRangeEx(cameraPosition, false, m_visibleDimension.width() / 2, m_visibleDimension.width() / 2 + 1, m_visibleDimension.height() / 2, m_visibleDimension.height() / 2 + 1)) {
         if (!creature->canBeSeen())
             continue;
@@ -249,17 +286,26 @@ void MapView::drawMapForeground(const Rect& rect)
         p.x = p.x * horizontalStretchFactor;
         p.y = p.y * verticalStretchFactor;
         p += rect.topLeft();
-        creatures.push_back(std::make_pair(creature, p));
-    }
 
-    for (auto& c : creatures) {
         int flags = Otc::DrawIcons;
         if (m_drawNames) { flags |= Otc::DrawNames; }
-        if ((!c.first->isLocalPlayer() || m_drawPlayerBars) && !m_drawHealthBarsOnTop) {
+        if (!creature->isLocalPlayer() || m_drawPlayerBars) {
             if (m_drawHealthBars) { flags |= Otc::DrawBars; }
             if (m_drawManaBar) { flags |= Otc::DrawManaBar; }
         }
-        c.first->drawInformation(c.second, g_map.isCovered(c.first->getPrewalkingPosition(), m_cachedFirstVisibleFloor), rect, flags);
+
+        creatures.push_back({ creature, p, g_map.isCovered(pos, m_cachedFirstVisibleFloor) });
+        CreatureInformation& c = creatures.back();
+        c.creature->layoutInformation(c.layout, c.point, c.covered, rect, flags, !m_drawHealthBarsOnTop);
+    }
+
+    // bars, names and icons of all creatures are drawn part by part, so each part ends up as a few big batches
+    // (bar rects and icons in the draw cache, names merged by the text batch) instead of switching per creature
+    for (int part : { Creature::InformationBars, Creature::InformationNames, Creature::InformationIcons }) {
+        if (part == Creature::InformationBars && m_drawHealthBarsOnTop)
+            continue;
+        for (auto& c : creatures)
+            c.creature->drawInformation(c.layout, part);
     }
 
     if (m_lightView) {
@@ -311,22 +357,37 @@ void MapView::drawMapForeground(const Rect& rect)
 
     // bars on top
     if (m_drawHealthBarsOnTop) {
-        for (auto& c : creatures) {
-            int flags = 0;
-            if ((!c.first->isLocalPlayer() || m_drawPlayerBars)) {
-                if (m_drawHealthBars) { flags |= Otc::DrawBars; }
-                if (m_drawManaBar) { flags |= Otc::DrawManaBar; }
-            }
-            c.first->drawInformation(c.second, g_map.isCovered(c.first->getPrewalkingPosition(), m_cachedFirstVisibleFloor), rect, flags);
-        }
+        for (auto& c : creatures)
+            c.creature->drawInformation(c.layout, Creature::InformationBars);
     }
 	
 	drawTileWidget(rect, srcRect);
+
+    g_adaptiveRenderer.addPhaseTime(AdaptiveRenderer::PhaseTexts, stdext::micros() - start);
+}
+
+
+namespace {
+// tiles of a floor are cached in drawing order, diagonal by diagonal from the top left corner
+// and from left to right inside a diagonal, the order doesn't depend on the camera
+bool drawsBefore(const Position& a, const Position& b)
+{
+    int diagonalA = a.x + a.y, diagonalB = b.x + b.y;
+    return diagonalA < diagonalB || (diagonalA == diagonalB && a.x < b.x);
 }
 
+bool tileDrawsBefore(const TilePtr& a, const TilePtr& b)
+{
+    return drawsBefore(a->getPosition(), b->getPosition());
+}
+}
 
 void MapView::updateVisibleTilesCache()
 {
+    if (!m_mustUpdateVisibleTilesCache && updateVisibleTilesCacheIncrementally(getCameraPosition()))
+        return;
+    m_pendingTileUpdates.clear();
+
     int prevFirstVisibleFloor = m_cachedFirstVisibleFloor;
     m_cachedFirstVisibleFloor = calcFirstVisibleFloor(false);
     m_cachedFirstFadingFloor = calcFirstVisibleFloor(true);
@@ -392,6 +453,165 @@ void MapView::updateVisibleTilesCache()
     }
 }
 
+bool MapView::updateVisibleTilesCacheIncrementally(const Position& cameraPosition)
+{
+    if (cameraPosition == m_lastCameraPosition && m_pendingTileUpdates.empty())
+        return true;
+
+    // walking a single step keeps the cache, teleports and floor changes rebuild it
+    if (!cameraPosition.isValid() || !m_lastCameraPosition.isValid() || cameraPosition.z != m_lastCameraPosition.z ||
+        std::abs(cameraPosition.x - m_lastCameraPosition.x) > 1 || std::abs(cameraPosition.y - m_lastCameraPosition.y) > 1)
+        return false;
+
+    // a changed tile can open or close the view to the floors above
+    if (calcFirstVisibleFloor(false) != m_cachedFirstVisibleFloor || calcFirstVisibleFloor(true) != m_cachedFirstFadingFloor ||
+        std::max<int>(calcLastVisibleFloor(), m_cachedFirstVisibleFloor) != m_cachedLastVisibleFloor)
+        return false;
+
+    std::sort(m_pendingTileUpdates.begin(), m_pendingTileUpdates.end(), [](const Position& a, const Position& b) {
+        return a.z < b.z || (a.z == b.z && drawsBefore(a, b));
+    });
+    m_pendingTileUpdates.erase(std::unique(m_pendingTileUpdates.begin(), m_pendingTileUpdates.end()), m_pendingTileUpdates.end());
+    if (m_pendingTileUpdates.size() > (size_t)m_drawDimension.area())
+        return false;
+
+    if (cameraPosition != m_lastCameraPosition)
+        shiftVisibleTilesCache(cameraPosition);
+
+    bool changedFloors[Otc::MAX_Z + 1] = { false };
+    for (const Position& pos : m_pendingTileUpdates) {
+        if (!isInVisibleTilesCacheArea(pos, cameraPosition))
+            continue;
+        updateVisibleTile(pos);
+        changedFloors[pos.z] = true;
+    }
+    m_pendingTileUpdates.clear();
+
+    // corpse correction spills over to the neighbour tiles, so it's redone for the whole floor like in a rebuild
+    for (int iz = 0; iz <= Otc::MAX_Z; ++iz) {
+        if (!changedFloors[iz] && cameraPosition == m_lastCameraPosition)
+            continue;
+        for (const TilePtr& tile : m_cachedVisibleTiles[iz])
+            tile->calculateCorpseCorrection();
+    }
+
+    m_lastCameraPosition = cameraPosition;
+    return true;
+}
+
+void MapView::shiftVisibleTilesCache(const Position& cameraPosition)
+{
+    int dx = cameraPosition.x - m_lastCameraPosition.x;
+    int dy = cameraPosition.y - m_lastCameraPosition.y;
+    for (int iz = m_cachedLastVisibleFloor; iz >= (m_floorFading ? m_cachedFirstFadingFloor : m_cachedFirstVisibleFloor); --iz) {
+        auto& tiles = m_cachedVisibleTiles[iz];
+        tiles.erase(std::remove_if(tiles.begin(), tiles.end(), [&](const TilePtr& tile) {
+            return !isInVisibleTilesCacheArea(tile->getPosition(), cameraPosition);
+        }), tiles.end());
+
+        // only the row and column which came into view are looked up
+        size_t keptTiles = tiles.size();
+        for (int ix = 0; ix < m_drawDimension.width(); ++ix) {
+            for (int iy = 0; iy < m_drawDimension.height(); ++iy) {
+                int prevX = ix + dx, prevY = iy + dy;
+                if (prevX >= 0 && prevX < m_drawDimension.width() && prevY >= 0 && prevY < m_drawDimension.height())
+                    continue;
+                Position tilePos = cameraPosition.translated(ix - m_virtualCenterOffset.x, iy - m_virtualCenterOffset.y);
+                tilePos.coveredUp(cameraPosition.z - iz);
+                if (const TilePtr& tile = g_map.getTile(tilePos)) {
+                    if (tile->isDrawable())
+                        tiles.push_back(tile);
+                }
+            }
+        }
+        std::sort(tiles.begin() + keptTiles, tiles.end(), tileDrawsBefore);
+        std::inplace_merge(tiles.begin(), tiles.begin() + keptTiles, tiles.end(), tileDrawsBefore);
+    }
+}
+
+void MapView::updateVisibleTile(const Position& pos)
+{
+    auto& tiles = m_cachedVisibleTiles[pos.z];
+    auto it = std::lower_bound(tiles.begin(), tiles.end(), pos, [](const TilePtr& tile, const Position& pos) {
+        return drawsBefore(tile->getPosition(), pos);
+    });
+    if (it != tiles.end() && (*it)->getPosition() == pos)
+        it = tiles.erase(it);
+
+    const TilePtr& tile = g_map.getTile(pos);
+    if (tile && tile->isDrawable())
+        tiles.insert(it, tile);
+}
+
+void MapView::updateOcclusion(const Position& cameraPosition)
+{
+    const int width = m_drawDimension.width(), height = m_drawDimension.height();
+    m_occludingFloor.assign(width * height, Otc::MAX_Z + 1);
+    m_occludingFloor2x2.assign(width * height, Otc::MAX_Z + 1);
+    if (!cameraPosition.isValid())
+        return;
+
+    // same rules as Map::isCompletelyCovered, a fully opaque tile hides the tiles geometrically below it when they
+    // have single dimension things only, bigger things need the top left neighbours to be opaque too
+    std::vector<bool> opaque;
+    for (int z = m_cachedFirstVisibleFloor; z < m_cachedLastVisibleFloor; ++z) {
+        // floors still fading in are see through
+        if (m_floorFading > 0 && m_fadingFloorTimers[z].elapsed_millis() < m_floorFading)
+            continue;
+
+        opaque.assign(width * height, false);
+        bool hasOpaqueTiles = false;
+        for (const TilePtr& tile : m_cachedVisibleTiles[z]) {
+            if (!tile->isFullyOpaque())
+                continue;
+            int cell = getTileCell(tile->getPosition(), cameraPosition);
+            if (cell < 0)
+                continue;
+            opaque[cell] = true;
+            hasOpaqueTiles = true;
+            if (m_occludingFloor[cell] > z)
+                m_occludingFloor[cell] = z;
+        }
+        if (!hasOpaqueTiles)
+            continue;
+
+        for (int y = 1; y < height; ++y) {
+            for (int x = 1; x < width; ++x) {
+                int cell = y * width + x;
+                if (m_occludingFloor2x2[cell] > z && opaque[cell] && opaque[cell - 1] && opaque[cell - width] && opaque[cell - width - 1])
+                    m_occludingFloor2x2[cell] = z;
+            }
+        }
+    }
+}
+
+bool MapView::isOccluded(const TilePtr& tile, const Position& cameraPosition)
+{
+    const Position& pos = tile->getPosition();
+    int cell = getTileCell(pos, cameraPosition);
+    if (cell < 0 || cell >= (int)m_occludingFloor.size())
+        return false;
+    if (m_occludingFloor2x2[cell] < pos.z)
+        return true;
+    return m_occludingFloor[cell] < pos.z && tile->isSingleDimension();
+}
+
+int MapView::getTileCell(const Position& pos, const Position& cameraPosition)
+{
+    int ix = pos.x - cameraPosition.x + m_virtualCenterOffset.x - (cameraPosition.z - pos.z);
+    int iy = pos.y - cameraPosition.y + m_virtualCenterOffset.y - (cameraPosition.z - pos.z);
+    if (ix < 0 || ix >= m_drawDimension.width() || iy < 0 || iy >= m_drawDimension.height())
+        return -1;
+    return iy * m_drawDimension.width() + ix;
+}
+
+bool MapView::isInVisibleTilesCacheArea(const Position& pos, const Position& cameraPosition)
+{
+    if (pos.z > m_cachedLastVisibleFloor || pos.z < (m_floorFading ? m_cachedFirstFadingFloor : m_cachedFirstVisibleFloor))
+        return false;
+    return getTileCell(pos, cameraPosition) >= 0;
+}
+
 void MapView::updateGeometry(const Size& visibleDimension, const Size& optimizedSize)
 {
     m_multifloor = true;
@@ -405,12 +625,21 @@ void MapView::updateGeometry(const Size& visibleDimension, const Size& optimized
 
 void MapView::onTileUpdate(const Position& pos)
 {
-    requestVisibleTilesCacheUpdate();
+    if (m_mustUpdateVisibleTilesCache)
+        return;
+
+    // a map description touches every tile several times, rebuilding is cheaper then
+    if (m_pendingTileUpdates.size() >= (size_t)m_drawDimension.area() * 4) {
+        m_pendingTileUpdates.clear();
+        requestVisibleTilesCacheUpdate();
+        return;
+    }
+    m_pendingTileUpdates.push_back(pos);
 }
 
 void MapView::onMapCenterChange(const Position& pos)
 {
-    requestVisibleTilesCacheUpdate();
+    // the camera move itself is picked up when the cache is updated before drawing
 }
 
 void MapView::lockFirstVisibleFloor(int firstVisibleFloor)
@@ -45,6 +45,13 @@ private:
     void drawTileWidget(const Rect& rect, const Rect& srcRect);
     void updateGeometry(const Size& visibleDimension, const Size& optimizedSize);
     void updateVisibleTilesCache();
+    bool updateVisibleTilesCacheIncrementally(const Position& cameraPosition);
+    void shiftVisibleTilesCache(const Position& cameraPosition);
+    void updateVisibleTile(const Position& pos);
+    bool isInVisibleTilesCacheArea(const Position& pos, const Position& cameraPosition);
+    void updateOcclusion(const Position& cameraPosition);
+    bool isOccluded(const TilePtr& tile, const Position& cameraPosition);
+    int getTileCell(const Position& pos, const Position& cameraPosition);
     void requestVisibleTilesCacheUpdate() { m_mustUpdateVisibleTilesCache = true; }
 
 protected:
@@ -110,7 +117,7 @@ public:
     void setAnimated(bool animated) { m_animated = animated; requestVisibleTilesCacheUpdate(); }
     bool isAnimating() { return m_animated; }
 
-    void setFloorFading(int value) { m_floorFading = value; }
+    void setFloorFading(int value) { m_floorFading = value; requestVisibleTilesCacheUpdate(); }
     void setCrosshair(const std::string& file);
 
     //void setShader(const PainterShaderProgramPtr& shader, float fadein, float fadeout);
@@ -160,6 +167,11 @@ private:
 
     stdext::boolean<true> m_follow;
     std::vector<TilePtr> m_cachedVisibleTiles[Otc::MAX_Z + 1];
+    std::vector<Position> m_pendingTileUpdates;
+    // per draw cell, the highest floor which hides the cell alone or together with its top left neighbours
+    std::vector<uint8> m_occludingFloor;
+    std::vector<uint8> m_occludingFloor2x2;
+    ticks_t m_creaturesTime = 0;
     CreaturePtr m_followingCreature;
     Otc::DrawFlags m_drawFlags;
     bool m_drawLight = false;
@@ -70,7 +70,10 @@ void MinimapBlock::update()
     }
 
     if(shouldDraw) {
-        m_texture = TexturePtr(new Texture(image));
+        if(m_texture)
+            m_texture->replace(image);
+        else
+            m_texture = TexturePtr(new Texture(image));
     } else
         m_texture.reset();
 
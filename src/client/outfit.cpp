@@ -407,6 +407,14 @@ bool DrawQueueItemOutfit::cache()
     return true;
 }
 
+bool DrawQueueItemOutfit::hash(uint64_t& hash, Rect& dest)
+{
+    if (!DrawQueueItemTexturedRect::hash(hash, dest))
+        return false;
+    hash ^= ((uint64_t)(uint32_t)m_colors * 1125899906842597ULL) + ((uint64_t)(uint32_t)m_offset.x << 16) + (uint32_t)m_offset.y;
+    return true;
+}
+
 void DrawQueueItemOutfit::draw()
 {
     if (!m_texture) return;
@@ -90,6 +90,7 @@ struct DrawQueueItemOutfit : public DrawQueueItemTexturedRect {
     void draw() override;
     void draw(const Point& pos) override;
     bool cache() override;
+    bool hash(uint64_t& hash, Rect& dest) override;
 
     Point m_offset;
     int32_t m_colors;
@@ -108,6 +109,10 @@ struct DrawQueueItemOutfitWithShader : public DrawQueueItemTexturedRect {
     {
         return false;
     }
+    bool hash(uint64_t& hash, Rect& dest) override
+    {
+        return false; // shaders animate on their own
+    }
 
     Point m_offset;
     Point m_center;
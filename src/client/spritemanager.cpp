@@ -24,6 +24,7 @@
 #include "game.h"
 #include <framework/core/resourcemanager.h>
 #include <framework/core/filestream.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/graphics/image.h>
 #include <framework/graphics/atlas.h>
 #include <framework/util/crypt.h>
@@ -47,7 +48,7 @@ bool SpriteManager::loadSpr(std::string file)
     m_spritesCount = 0;
     m_signature = 0;
     m_loaded = false;
-    m_sprites.clear();
+    clearSpriteData();
 
     auto cwmFile = g_resources.guessFilePath(file, "cwm");
     if (g_resources.fileExists(cwmFile)) {
@@ -299,7 +300,36 @@ void SpriteManager::unload()
     m_spritesCount = 0;
     m_signature = 0;
     m_spritesFile = nullptr;
-    m_sprites.clear();
+    clearSpriteData();
+}
+
+void SpriteManager::clearSpriteData()
+{
+    std::vector<uint8_t>().swap(m_spriteData);
+    std::vector<uint32>().swap(m_spriteOffsets);
+    m_spriteStates.reset();
+
+    std::lock_guard<std::mutex> lock(m_hdCacheMutex);
+    m_hdCache.clear();
+    m_hdCacheLru.clear();
+    m_hdCacheBytes = 0;
+}
+
+void SpriteManager::setHdCacheSize(int megabytes)
+{
+    std::lock_guard<std::mutex> lock(m_hdCacheMutex);
+    m_hdCacheLimit = (size_t)std::max<int>(megabytes, 0) * 1024 * 1024;
+    trimHdCache();
+}
+
+void SpriteManager::trimHdCache()
+{
+    while (m_hdCacheBytes > m_hdCacheLimit && !m_hdCacheLru.empty()) {
+        auto it = m_hdCache.find(m_hdCacheLru.back());
+        m_hdCacheBytes -= it->second.image->getPixels().size();
+        m_hdCache.erase(it);
+        m_hdCacheLru.pop_back();
+    }
 }
 
 ImagePtr SpriteManager::getSpriteImage(int id)
@@ -324,14 +354,33 @@ bool SpriteManager::loadCasualSpr(std::string file)
         if (m_signature == *((uint32_t*)"OTV8")) {
             m_signature = m_spritesFile->getU32();
             m_spritesCount = m_spritesFile->getU32();
-            m_sprites.resize(m_spritesCount + 1);
+
+            // read the whole payload at once and strip the size prefixes in place
+            uint32 dataSize = m_spritesFile->size() - m_spritesFile->tell();
+            m_spriteData.resize(dataSize);
+            if (dataSize > 0)
+                m_spritesFile->read(m_spriteData.data(), dataSize);
+
+            m_spriteOffsets.resize(m_spritesCount + 2);
+            m_spriteOffsets[0] = 0;
+            uint32 readPos = 0, writePos = 0;
             for (int i = 1; i <= m_spritesCount; ++i) {
-                int bufferSize = m_spritesFile->getU16();
-                if (bufferSize == 0) continue;
-                m_sprites[i].resize(bufferSize + 1);
-                m_sprites[i][0] = 0;
-                m_spritesFile->read(m_sprites[i].data() + 1, bufferSize);
+                if (readPos + 2 > dataSize)
+                    stdext::throw_exception("unexpected end of file");
+                uint16 bufferSize = stdext::readULE16(&m_spriteData[readPos]);
+                readPos += 2;
+                if (readPos + bufferSize > dataSize)
+                    stdext::throw_exception("unexpected end of file");
+                m_spriteOffsets[i] = writePos;
+                std::memmove(m_spriteData.data() + writePos, m_spriteData.data() + readPos, bufferSize);
+                readPos += bufferSize;
+                writePos += bufferSize;
             }
+            m_spriteOffsets[m_spritesCount + 1] = writePos;
+            m_spriteData.resize(writePos);
+            m_spriteStates.reset(new std::atomic<uint8_t>[m_spritesCount + 1]);
+            for (int i = 0; i <= m_spritesCount; ++i)
+                m_spriteStates[i] = SpriteEncrypted;
             m_spritesFile = nullptr;
         }
         else {
@@ -385,29 +434,38 @@ ImagePtr SpriteManager::getSpriteImageCasual(int id)
     try {
         int spriteDataSize = m_spriteSize * m_spriteSize * 4;
 
-        if (!m_sprites.empty()) {
-            if (id >= (int)m_sprites.size())
+        if (!m_spriteOffsets.empty()) {
+            if (id <= 0 || id > m_spritesCount)
                 return nullptr;
-            auto& buffer = m_sprites[id];
-            if (buffer.size() < 5)
+            uint32 bufferSize = m_spriteOffsets[id + 1] - m_spriteOffsets[id];
+            if (bufferSize < 4)
                 return nullptr;
-            if (buffer[0] == 0) {
-                buffer[0] = 1;
-                g_crypt.bdecrypt(buffer.data() + 1, buffer.size() - 1, (uint64_t)m_signature + id);
+            uint8_t* buffer = m_spriteData.data() + m_spriteOffsets[id];
+            // decrypted in place once, other threads wait for the one doing it
+            std::atomic<uint8_t>& state = m_spriteStates[id];
+            if (state.load(std::memory_order_acquire) != SpriteDecrypted) {
+                uint8_t expected = SpriteEncrypted;
+                if (state.compare_exchange_strong(expected, SpriteDecrypting, std::memory_order_acquire)) {
+                    g_crypt.bdecrypt(buffer, bufferSize, (uint64_t)m_signature + id);
+                    state.store(SpriteDecrypted, std::memory_order_release);
+                } else {
+                    while (state.load(std::memory_order_acquire) != SpriteDecrypted)
+                        std::this_thread::yield();
+                }
             }
 
-            if (buffer[1] > 1) {
+            if (buffer[0] > 1) {
                 stdext::throw_exception("Invalid sprite encryption");
             }
 
-            bool hasAlpha = (buffer[1] == 1);
+            bool hasAlpha = (buffer[0] == 1);
 
             ImagePtr image(new Image(Size(m_spriteSize, m_spriteSize)));
             uint8* pixels = image->getPixelData();
             int writePos = 0;
 
-            size_t bufferPos = 2;
-            while (bufferPos != buffer.size()) {
+            uint32 bufferPos = 1;
+            while (bufferPos != bufferSize) {
                 uint16_t transparentPixels = *(uint16_t*)(&buffer[bufferPos]);
                 bufferPos += 2;
                 uint16_t coloredPixels = *(uint16_t*)(&buffer[bufferPos]);
@@ -431,25 +489,29 @@ ImagePtr SpriteManager::getSpriteImageCasual(int id)
             return image;
         }
 
-        if (id == 0 || !m_spritesFile)
+        FileStreamPtr spritesFile = m_spritesFile;
+        if (id <= 0 || id > m_spritesCount || !spritesFile)
             return nullptr;
 
-        m_spritesFile->seek(((id - 1) * 4) + m_spritesOffset);
-
-        uint32 spriteAddress = m_spritesFile->getU32();
+        // positional reads only, so several threads can decode at once
+        uint8 spriteAddressData[4];
+        if (spritesFile->readAt(((id - 1) * 4) + m_spritesOffset, spriteAddressData, 4) != 4)
+            stdext::throw_exception("read failed");
+        uint32 spriteAddress = stdext::readULE32(spriteAddressData);
 
         // no sprite? return an empty texture
         if (spriteAddress == 0)
             return nullptr;
 
-        m_spritesFile->seek(spriteAddress);
-
-        // color key
-        m_spritesFile->getU8();
-        m_spritesFile->getU8();
-        m_spritesFile->getU8();
+        // color key and pixel data size
+        uint8 header[5];
+        if (spritesFile->readAt(spriteAddress, header, 5) != 5)
+            stdext::throw_exception("read failed");
+        uint16 pixelDataSize = stdext::readULE16(header + 3);
 
-        uint16 pixelDataSize = m_spritesFile->getU16();
+        std::vector<uint8> buffer(pixelDataSize);
+        if (pixelDataSize > 0 && spritesFile->readAt(spriteAddress + 5, buffer.data(), pixelDataSize) != pixelDataSize)
+            stdext::throw_exception("read failed");
 
         ImagePtr image(new Image(Size(m_spriteSize, m_spriteSize)));
 
@@ -459,27 +521,30 @@ ImagePtr SpriteManager::getSpriteImageCasual(int id)
         bool useAlpha = g_game.getFeature(Otc::GameSpritesAlphaChannel);
 
         // decompress pixels
-        while (read < pixelDataSize && writePos < spriteDataSize) {
-            uint16 transparentPixels = m_spritesFile->getU16();
-            uint16 coloredPixels = m_spritesFile->getU16();
+        while (read + 4 <= pixelDataSize && writePos < spriteDataSize) {
+            uint16 transparentPixels = stdext::readULE16(&buffer[read]);
+            uint16 coloredPixels = stdext::readULE16(&buffer[read + 2]);
+            read += 4;
 
             writePos += transparentPixels * 4;
 
+            int pixelSize = useAlpha ? 4 : 3;
+            int coloredCount = std::min<int>(coloredPixels, (pixelDataSize - read) / pixelSize);
             if (useAlpha) {
-                m_spritesFile->read(&pixels[writePos], std::min<uint16>(coloredPixels * 4, spriteDataSize - writePos));
+                if (writePos < spriteDataSize)
+                    memcpy(&pixels[writePos], &buffer[read], std::min<int>(coloredCount * 4, spriteDataSize - writePos));
                 writePos += coloredPixels * 4;
-                read += 4 + (4 * coloredPixels);
             }
             else {
-                for (int i = 0; i < coloredPixels && writePos < spriteDataSize; i++) {
-                    pixels[writePos + 0] = m_spritesFile->getU8();
-                    pixels[writePos + 1] = m_spritesFile->getU8();
-                    pixels[writePos + 2] = m_spritesFile->getU8();
+                for (int i = 0; i < coloredCount && writePos < spriteDataSize; i++) {
+                    pixels[writePos + 0] = buffer[read + i * 3 + 0];
+                    pixels[writePos + 1] = buffer[read + i * 3 + 1];
+                    pixels[writePos + 2] = buffer[read + i * 3 + 2];
                     pixels[writePos + 3] = 0xFF;
                     writePos += 4;
                 }
-                read += 4 + (3 * coloredPixels);
             }
+            read += pixelSize * coloredPixels;
         }
 
         return image;
@@ -495,13 +560,80 @@ ImagePtr SpriteManager::getSpriteImageHd(int id)
     if (id == 0 || !m_loaded)
         return nullptr;
 
-    if (m_cachedData.find(id) == m_cachedData.end())
+    // callers may modify the image they get, so hand out copies of the cached one
+    {
+        std::lock_guard<std::mutex> lock(m_hdCacheMutex);
+        auto it = m_hdCache.find(id);
+        if (it != m_hdCache.end()) {
+            m_hdCacheLru.splice(m_hdCacheLru.begin(), m_hdCacheLru, it->second.lruIt);
+            const ImagePtr& image = it->second.image;
+            return ImagePtr(new Image(image->getSize(), image->getBpp(), image->getPixelData()));
+        }
+    }
+
+    auto it = m_cachedData.find(id);
+    if (it == m_cachedData.end())
     {
         return nullptr;
     }
 
+    ImagePtr image;
     try {
-        return Image::loadPNG(m_cachedData[id].data(), m_cachedData[id].size());
+        image = Image::loadPNG(it->second.data(), it->second.size());
     } catch (...) {}
-    return nullptr;
+    if (!image)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_hdCacheMutex);
+    size_t imageBytes = image->getPixels().size();
+    if (imageBytes <= m_hdCacheLimit && m_hdCache.find(id) == m_hdCache.end()) {
+        m_hdCacheLru.push_front(id);
+        m_hdCache[id] = { ImagePtr(new Image(image->getSize(), image->getBpp(), image->getPixelData())), m_hdCacheLru.begin() };
+        m_hdCacheBytes += imageBytes;
+        trimHdCache();
+    }
+    return image;
+}
+
+std::vector<ImagePtr> SpriteManager::decodeSprites(const std::vector<int>& ids)
+{
+    struct DecodeBatch {
+        std::vector<int> ids;
+        std::vector<ImagePtr> images;
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    auto batch = std::make_shared<DecodeBatch>();
+    batch->ids = ids;
+    batch->images.resize(ids.size());
+    batch->next = 0;
+    batch->done = 0;
+    if (ids.empty())
+        return batch->images;
+
+    // workers pull ids until none are left, so workers that start late (or
+    // never, while the async dispatcher is busy) don't hold up the caller
+    auto work = [this, batch] {
+        size_t i;
+        while ((i = batch->next++) < batch->ids.size()) {
+            batch->images[i] = getSpriteImage(batch->ids[i]);
+            if (++batch->done == batch->ids.size()) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t spritesPerWorker = 64;
+    size_t workers = std::min<size_t>(3, (ids.size() - 1) / spritesPerWorker);
+    for (size_t i = 0; i < workers; ++i)
+        g_asyncDispatcher.dispatch(work);
+    work();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&] { return batch->done == batch->ids.size(); });
+    return std::move(batch->images);
 }
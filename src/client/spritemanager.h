@@ -48,16 +48,29 @@ public:
     uint32 getSignature() { return m_signature; }
     int getSpritesCount() { return m_spritesCount; }
 
+    // safe to call from any thread
     ImagePtr getSpriteImage(int id);
+    // decodes on the async dispatcher threads and the calling thread, returns images in ids order
+    std::vector<ImagePtr> decodeSprites(const std::vector<int>& ids);
     bool isLoaded() { return m_loaded; }
 
     int spriteSize() { return m_spriteSize; }
     float getOffsetFactor() const { return static_cast<float>(m_spriteSize) / 32.0f; }
     bool isHdMod() const { return m_isHdMod; }
 
+    void setHdCacheSize(int megabytes);
+    int getHdCacheSize() { return m_hdCacheLimit / (1024 * 1024); }
+
 private:
+    enum SpriteState : uint8_t {
+        SpriteEncrypted = 0,
+        SpriteDecrypting,
+        SpriteDecrypted
+    };
+
     bool loadCasualSpr(std::string file);
     bool loadCwmSpr(std::string file);
+    void clearSpriteData();
 
     ImagePtr getSpriteImageCasual(int id);
     ImagePtr getSpriteImageHd(int id);
@@ -68,8 +81,23 @@ private:
     int m_spritesOffset;
     int m_spriteSize;
     FileStreamPtr m_spritesFile;
-    std::vector<std::vector<uint8_t>> m_sprites;
+    // OTV8: all sprites in one block, sprite i spans [m_spriteOffsets[i], m_spriteOffsets[i + 1])
+    std::vector<uint8_t> m_spriteData;
+    std::vector<uint32> m_spriteOffsets;
+    std::unique_ptr<std::atomic<uint8_t>[]> m_spriteStates;
     std::unordered_map<uint32, std::string> m_cachedData;
+
+    // decoded cwm sprites, least recently used are dropped above m_hdCacheLimit bytes
+    struct DecodedSprite {
+        ImagePtr image;
+        std::list<int>::iterator lruIt;
+    };
+    void trimHdCache();
+    std::unordered_map<int, DecodedSprite> m_hdCache;
+    std::list<int> m_hdCacheLru;
+    size_t m_hdCacheBytes = 0;
+    size_t m_hdCacheLimit = 64 * 1024 * 1024;
+    std::mutex m_hdCacheMutex;
 };
 
 extern SpriteManager g_sprites;
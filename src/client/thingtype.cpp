@@ -55,34 +55,28 @@ void ThingType::serialize(const FileStreamPtr& fin)
         if(!hasAttr((ThingAttr)i))
             continue;
 
-        int attr = i;
-        if(g_game.getClientVersion() >= 780) {
-            if(attr == ThingAttrChargeable)
-                attr = ThingAttrWritable;
-            else if(attr >= ThingAttrWritable)
-                attr += 1;
-        } else if(g_game.getClientVersion() >= 1000) {
-            if(attr == ThingAttrNoMoveAnimation)
-                attr = 16;
-            else if(attr >= ThingAttrPickupable)
-                attr += 1;
-        }
+        // attributes that the current client version can't store are dropped
+        int attr = denormalizeDatAttr(i);
+        if(attr < 0)
+            continue;
 
+        // payloads follow the attribute as stored, same as unserialize reads them
         fin->addU8(attr);
-        switch(attr) {
+        switch(i) {
             case ThingAttrDisplacement: {
-                fin->addU16(m_displacement.x);
-                fin->addU16(m_displacement.y);
+                if(g_game.getClientVersion() >= 755) {
+                    fin->addU16(m_displacement.x);
+                    fin->addU16(m_displacement.y);
+                }
                 break;
             }
             case ThingAttrLight: {
-                Light light = m_attribs.get<Light>(attr);
-                fin->addU16(light.intensity);
-                fin->addU16(light.color);
+                fin->addU16(m_light.intensity);
+                fin->addU16(m_light.color);
                 break;
             }
             case ThingAttrMarket: {
-                MarketData market = m_attribs.get<MarketData>(attr);
+                MarketData market = getMarketData();
                 fin->addU16(market.category);
                 fin->addU16(market.tradeAs);
                 fin->addU16(market.showAs);
@@ -91,22 +85,40 @@ void ThingType::serialize(const FileStreamPtr& fin)
                 fin->addU16(market.requiredLevel);
                 break;
             }
-            case ThingAttrUsable:
             case ThingAttrElevation:
+                fin->addU16(m_elevation);
+                break;
+            case ThingAttrUsable:
             case ThingAttrGround:
             case ThingAttrWritable:
             case ThingAttrWritableOnce:
             case ThingAttrMinimapColor:
             case ThingAttrCloth:
-            case ThingAttrLensHelp:
-                fin->addU16(m_attribs.get<uint16>(attr));
+            case ThingAttrLensHelp: {
+                uint16* value = getAttrValue(i);
+                fin->addU16(value ? *value : 0);
                 break;
+            }
+            case ThingAttrBones: {
+                for(int direction : { Otc::North, Otc::South, Otc::East, Otc::West }) {
+                    Point bone = (int)m_bones.size() > direction ? m_bones[direction] : Point();
+                    fin->addU16(bone.x);
+                    fin->addU16(bone.y);
+                }
+                break;
+            }
             default:
                 break;
         };
     }
     fin->addU8(ThingLastAttr);
 
+    // frame groups were merged at load, they are saved back as a single group
+    if(m_category == ThingCategoryCreature && g_game.getFeature(Otc::GameIdleAnimations)) {
+        fin->addU8(1);
+        fin->addU8(FrameGroupDefault);
+    }
+
     fin->addU8(m_size.width());
     fin->addU8(m_size.height());
 
@@ -116,7 +128,8 @@ void ThingType::serialize(const FileStreamPtr& fin)
     fin->addU8(m_layers);
     fin->addU8(m_numPatternX);
     fin->addU8(m_numPatternY);
-    fin->addU8(m_numPatternZ);
+    if(g_game.getClientVersion() >= 755)
+        fin->addU8(m_numPatternZ);
     fin->addU8(m_animationPhases);
 
     if(g_game.getFeature(Otc::GameEnhancedAnimations)) {
@@ -133,6 +146,180 @@ void ThingType::serialize(const FileStreamPtr& fin)
     }
 }
 
+bool ThingType::isSameDatEntry(const ThingTypePtr& other)
+{
+    if(m_flags != other->m_flags || m_spritesIndex != other->m_spritesIndex)
+        return false;
+
+    if(m_size != other->m_size || m_layers != other->m_layers || m_animationPhases != other->m_animationPhases ||
+       m_numPatternX != other->m_numPatternX || m_numPatternY != other->m_numPatternY || m_numPatternZ != other->m_numPatternZ)
+        return false;
+
+    for(int attr : { ThingAttrGround, ThingAttrWritable, ThingAttrWritableOnce, ThingAttrMinimapColor,
+                     ThingAttrCloth, ThingAttrLensHelp, ThingAttrUsable }) {
+        if(hasAttr((ThingAttr)attr) && *getAttrValue(attr) != *other->getAttrValue(attr))
+            return false;
+    }
+
+    if(m_elevation != other->m_elevation || m_displacement != other->m_displacement ||
+       m_light.intensity != other->m_light.intensity || m_light.color != other->m_light.color)
+        return false;
+
+    MarketData market = getMarketData(), otherMarket = other->getMarketData();
+    return market.name == otherMarket.name && market.category == otherMarket.category &&
+           market.tradeAs == otherMarket.tradeAs && market.showAs == otherMarket.showAs &&
+           market.restrictVocation == otherMarket.restrictVocation && market.requiredLevel == otherMarket.requiredLevel;
+}
+
+int ThingType::normalizeDatAttr(int attr)
+{
+    if(g_game.getClientVersion() >= 1000) {
+        /* In 10.10+ all attributes from 16 and up were
+         * incremented by 1 to make space for 16 as
+         * "No Movement Animation" flag.
+         */
+        if(attr == 16)
+            attr = ThingAttrNoMoveAnimation;
+        else if(attr > 16)
+            attr -= 1;
+    } else if(g_game.getClientVersion() >= 860) {
+        /* Default attribute values follow
+         * the format of 8.6-9.86.
+         * Therefore no changes here.
+         */
+    } else if(g_game.getClientVersion() >= 780) {
+        /* In 7.80-8.54 all attributes from 8 and higher were
+         * incremented by 1 to make space for 8 as
+         * "Item Charges" flag.
+         */
+        if(attr == 8)
+            attr = ThingAttrChargeable;
+        else if(attr > 8)
+            attr -= 1;
+    } else if(g_game.getClientVersion() >= 755) {
+        /* In 7.55-7.72 attributes 23 is "Floor Change". */
+        if(attr == 23)
+            attr = ThingAttrFloorChange;
+    } else if(g_game.getClientVersion() >= 740) {
+        /* In 7.4-7.5 attribute "Ground Border" did not exist
+         * attributes 1-15 have to be adjusted.
+         * Several other changes in the format.
+         */
+        if(attr > 0 && attr <= 15)
+            attr += 1;
+        else if(attr == 16)
+            attr = ThingAttrLight;
+        else if(attr == 17)
+            attr = ThingAttrFloorChange;
+        else if(attr == 18)
+            attr = ThingAttrFullGround;
+        else if(attr == 19)
+            attr = ThingAttrElevation;
+        else if(attr == 20)
+            attr = ThingAttrDisplacement;
+        else if(attr == 22)
+            attr = ThingAttrMinimapColor;
+        else if(attr == 23)
+            attr = ThingAttrRotateable;
+        else if(attr == 24)
+            attr = ThingAttrLyingCorpse;
+        else if(attr == 25)
+            attr = ThingAttrHangable;
+        else if(attr == 26)
+            attr = ThingAttrHookSouth;
+        else if(attr == 27)
+            attr = ThingAttrHookEast;
+        else if(attr == 28)
+            attr = ThingAttrAnimateAlways;
+
+        /* "Multi Use" and "Force Use" are swapped */
+        if(attr == ThingAttrMultiUse)
+            attr = ThingAttrForceUse;
+        else if(attr == ThingAttrForceUse)
+            attr = ThingAttrMultiUse;
+    }
+    return attr;
+}
+
+int ThingType::denormalizeDatAttr(int attr)
+{
+    // inverse of normalizeDatAttr, so saved files always load back the same
+    for(int datAttr = 0; datAttr < ThingLastAttr; ++datAttr) {
+        if(normalizeDatAttr(datAttr) == attr)
+            return datAttr;
+    }
+    return -1;
+}
+
+void ThingType::skipDatEntry(ThingCategory category, const FileStreamPtr& fin)
+{
+    bool done = false;
+    for(int i = 0 ; i < ThingLastAttr;++i) {
+        int attr = fin->getU8();
+        if(attr == ThingLastAttr) {
+            done = true;
+            break;
+        }
+
+        // must read the same payloads as unserialize
+        switch(normalizeDatAttr(attr)) {
+            case ThingAttrDisplacement:
+                if(g_game.getClientVersion() >= 755)
+                    fin->skip(4);
+                break;
+            case ThingAttrLight:
+                fin->skip(4);
+                break;
+            case ThingAttrMarket:
+                fin->skip(6);
+                fin->skip(fin->getU16());
+                fin->skip(4);
+                break;
+            case ThingAttrElevation:
+            case ThingAttrUsable:
+            case ThingAttrGround:
+            case ThingAttrWritable:
+            case ThingAttrWritableOnce:
+            case ThingAttrMinimapColor:
+            case ThingAttrCloth:
+            case ThingAttrLensHelp:
+                fin->skip(2);
+                break;
+            case ThingAttrBones:
+                fin->skip(16);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if(!done)
+        stdext::throw_exception(stdext::format("corrupt data (category: %d)", category));
+
+    bool hasFrameGroups = (category == ThingCategoryCreature && g_game.getFeature(Otc::GameIdleAnimations));
+    uint8 groupCount = hasFrameGroups ? fin->getU8() : 1;
+    for(int i = 0; i < groupCount; ++i) {
+        if(hasFrameGroups)
+            fin->skip(1);
+
+        int width = fin->getU8();
+        int height = fin->getU8();
+        if(width > 1 || height > 1)
+            fin->skip(1);
+
+        int layers = fin->getU8();
+        int numPatternX = fin->getU8();
+        int numPatternY = fin->getU8();
+        int numPatternZ = g_game.getClientVersion() >= 755 ? fin->getU8() : 1;
+        int animationPhases = fin->getU8();
+        if(animationPhases > 1 && g_game.getFeature(Otc::GameEnhancedAnimations))
+            fin->skip(6 + 8 * animationPhases);
+
+        int totalSprites = width * height * layers * numPatternX * numPatternY * numPatternZ * animationPhases;
+        fin->skip(totalSprites * (g_game.getFeature(Otc::GameSpritesU32) ? 4 : 2));
+    }
+}
+
 void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileStreamPtr& fin)
 {
     m_null = false;
@@ -149,72 +336,7 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
             break;
         }
 
-        if(g_game.getClientVersion() >= 1000) {
-            /* In 10.10+ all attributes from 16 and up were
-             * incremented by 1 to make space for 16 as
-             * "No Movement Animation" flag.
-             */
-            if(attr == 16)
-                attr = ThingAttrNoMoveAnimation;
-            else if(attr > 16)
-                attr -= 1;
-        } else if(g_game.getClientVersion() >= 860) {
-            /* Default attribute values follow
-             * the format of 8.6-9.86.
-             * Therefore no changes here.
-             */
-        } else if(g_game.getClientVersion() >= 780) {
-            /* In 7.80-8.54 all attributes from 8 and higher were
-             * incremented by 1 to make space for 8 as
-             * "Item Charges" flag.
-             */
-            if(attr == 8) {
-                m_attribs.set(ThingAttrChargeable, true);
-                continue;
-            } else if(attr > 8)
-                attr -= 1;
-        } else if(g_game.getClientVersion() >= 755) {
-            /* In 7.55-7.72 attributes 23 is "Floor Change". */
-            if(attr == 23)
-                attr = ThingAttrFloorChange;
-        } else if(g_game.getClientVersion() >= 740) {
-            /* In 7.4-7.5 attribute "Ground Border" did not exist
-             * attributes 1-15 have to be adjusted.
-             * Several other changes in the format.
-             */
-            if(attr > 0 && attr <= 15)
-                attr += 1;
-            else if(attr == 16)
-                attr = ThingAttrLight;
-            else if(attr == 17)
-                attr = ThingAttrFloorChange;
-            else if(attr == 18)
-                attr = ThingAttrFullGround;
-            else if(attr == 19)
-                attr = ThingAttrElevation;
-            else if(attr == 20)
-                attr = ThingAttrDisplacement;
-            else if(attr == 22)
-                attr = ThingAttrMinimapColor;
-            else if(attr == 23)
-                attr = ThingAttrRotateable;
-            else if(attr == 24)
-                attr = ThingAttrLyingCorpse;
-            else if(attr == 25)
-                attr = ThingAttrHangable;
-            else if(attr == 26)
-                attr = ThingAttrHookSouth;
-            else if(attr == 27)
-                attr = ThingAttrHookEast;
-            else if(attr == 28)
-                attr = ThingAttrAnimateAlways;
-
-            /* "Multi Use" and "Force Use" are swapped */
-            if(attr == ThingAttrMultiUse)
-                attr = ThingAttrForceUse;
-            else if(attr == ThingAttrForceUse)
-                attr = ThingAttrMultiUse;
-        }
+        attr = normalizeDatAttr(attr);
 
         switch(attr) {
             case ThingAttrDisplacement: {
@@ -225,30 +347,29 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
                     m_displacement.x = 8;
                     m_displacement.y = 8;
                 }
-                m_attribs.set(attr, true);
+                m_flags.set(attr);
                 break;
             }
             case ThingAttrLight: {
-                Light light;
-                light.intensity = fin->getU16();
-                light.color = fin->getU16();
-                m_attribs.set(attr, light);
+                m_light.intensity = fin->getU16();
+                m_light.color = fin->getU16();
+                m_flags.set(attr);
                 break;
             }
             case ThingAttrMarket: {
-                MarketData market;
-                market.category = fin->getU16();
-                market.tradeAs = fin->getU16();
-                market.showAs = fin->getU16();
-                market.name = fin->getString();
-                market.restrictVocation = fin->getU16();
-                market.requiredLevel = fin->getU16();
-                m_attribs.set(attr, market);
+                m_marketData.reset(new MarketData);
+                m_marketData->category = fin->getU16();
+                m_marketData->tradeAs = fin->getU16();
+                m_marketData->showAs = fin->getU16();
+                m_marketData->name = fin->getString();
+                m_marketData->restrictVocation = fin->getU16();
+                m_marketData->requiredLevel = fin->getU16();
+                m_flags.set(attr);
                 break;
             }
             case ThingAttrElevation: {
                 m_elevation = fin->getU16();
-                m_attribs.set(attr, m_elevation);
+                m_flags.set(attr);
                 break;
             }
             case ThingAttrUsable:
@@ -258,7 +379,8 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
             case ThingAttrMinimapColor:
             case ThingAttrCloth:
             case ThingAttrLensHelp:
-                m_attribs.set(attr, fin->getU16());
+                *getAttrValue(attr) = fin->getU16();
+                m_flags.set(attr);
                 break;
             case ThingAttrBones: {
                 m_bones.resize(4);
@@ -270,11 +392,11 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
                 m_bones[Otc::East] = Point(x, y);
                 x = fin->getU16(), y = fin->getU16();
                 m_bones[Otc::West] = Point(x, y);
-                m_attribs.set(attr, true);
+                m_flags.set(attr);
                 break;
             }
             default:
-                m_attribs.set(attr, true);
+                m_flags.set(attr);
                 break;
         };
     }
@@ -389,11 +511,6 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
         m_idleAnimator = nullptr;
     }
 
-    m_textures.resize(m_animationPhases);
-    m_texturesFramesRects.resize(m_animationPhases);
-    m_texturesFramesOriginRects.resize(m_animationPhases);
-    m_texturesFramesOffsets.resize(m_animationPhases);
-
     m_lastUsage = g_clock.seconds();
 }
 
@@ -478,29 +595,19 @@ void ThingType::unserializeOtml(const OTMLNodePtr& node)
         if(node2->tag() == "opacity")
             m_opacity = node2->value<float>();
         else if(node2->tag() == "notprewalkable")
-            m_attribs.set(ThingAttrNotPreWalkable, node2->value<bool>());
+            m_flags.set(ThingAttrNotPreWalkable, node2->value<bool>());
         else if(node2->tag() == "image")
             m_customImage = node2->value();
-        else if(node2->tag() == "full-ground") {
-            if(node2->value<bool>())
-                m_attribs.set(ThingAttrFullGround, true);
-            else
-                m_attribs.remove(ThingAttrFullGround);
-        }
+        else if(node2->tag() == "full-ground")
+            m_flags.set(ThingAttrFullGround, node2->value<bool>());
     }
 }
 
 void ThingType::unload()
 {
-    m_textures.clear();
-    m_texturesFramesRects.clear();
-    m_texturesFramesOriginRects.clear();
-    m_texturesFramesOffsets.clear();
-
-    m_textures.resize(m_animationPhases);
-    m_texturesFramesRects.resize(m_animationPhases);
-    m_texturesFramesOriginRects.resize(m_animationPhases);
-    m_texturesFramesOffsets.resize(m_animationPhases);
+    std::lock_guard<std::mutex> lock(m_texturesMutex);
+    std::vector<TexturePtr>().swap(m_textures);
+    std::vector<std::vector<TextureFrame>>().swap(m_texturesFrames);
 
     m_loaded = false;
 }
@@ -513,16 +620,16 @@ DrawQueueItem* ThingType::draw(const Point& dest, int layer, int xPattern, int y
     if (animationPhase < 0 || animationPhase >= m_animationPhases)
         return nullptr;
 
-    const TexturePtr& texture = getTexture(animationPhase); // texture might not exists, neither its rects.
+    TexturePtr texture = getTexture(animationPhase); // texture might not exists, neither its rects.
     if (!texture)
         return nullptr;
 
     uint frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
-    if (frameIndex >= m_texturesFramesRects[animationPhase].size())
+    if (frameIndex >= m_texturesFrames[animationPhase].size())
         return nullptr;
 
-    Point textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    Rect textureRect = m_texturesFramesRects[animationPhase][frameIndex];
+    Point textureOffset = m_texturesFrames[animationPhase][frameIndex].offset;
+    Rect textureRect = m_texturesFrames[animationPhase][frameIndex].rect;
 
     Rect screenRect(dest + (textureOffset - m_displacement * g_sprites.getOffsetFactor() - (m_size.toPoint() - Point(1, 1)) * g_sprites.spriteSize()), textureRect.size());
 
@@ -544,16 +651,16 @@ DrawQueueItem* ThingType::draw(const Rect& dest, int layer, int xPattern, int yP
     if (animationPhase < 0 || animationPhase >= m_animationPhases)
         return nullptr;
 
-    const TexturePtr& texture = getTexture(animationPhase); // texture might not exists, neither its rects.
+    TexturePtr texture = getTexture(animationPhase); // texture might not exists, neither its rects.
     if (!texture)
         return nullptr;
 
     uint frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
-    if (frameIndex >= m_texturesFramesRects[animationPhase].size())
+    if (frameIndex >= m_texturesFrames[animationPhase].size())
         return nullptr;
 
-    Point textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    Rect textureRect = m_texturesFramesRects[animationPhase][frameIndex];
+    Point textureOffset = m_texturesFrames[animationPhase][frameIndex].offset;
+    Rect textureRect = m_texturesFrames[animationPhase][frameIndex].rect;
 
     bool useOpacity = m_opacity < 1.0f;
     if (useOpacity)
@@ -583,19 +690,19 @@ std::shared_ptr<DrawOutfitParams> ThingType::drawOutfit(const Point& dest, int m
     if (animationPhase < 0 || animationPhase >= m_animationPhases)
         return nullptr;
 
-    const TexturePtr& texture = getTexture(animationPhase); // texture might not exists, neither its rects.
+    TexturePtr texture = getTexture(animationPhase); // texture might not exists, neither its rects.
     if (!texture)
         return nullptr;
 
     uint frameIndex = getTextureIndex(0, xPattern, yPattern, zPattern);
     uint frameIndex2 = getTextureIndex(maskLayer, xPattern, yPattern, zPattern);
-    if (frameIndex >= m_texturesFramesRects[animationPhase].size() || frameIndex2 >= m_texturesFramesRects[animationPhase].size())
+    if (frameIndex >= m_texturesFrames[animationPhase].size() || frameIndex2 >= m_texturesFrames[animationPhase].size())
         return nullptr;
 
-    Point textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    Point textureOffset2 = m_texturesFramesOffsets[animationPhase][frameIndex2];
-    Rect textureRect = m_texturesFramesRects[animationPhase][frameIndex];
-    Rect textureRect2 = m_texturesFramesRects[animationPhase][frameIndex2];
+    Point textureOffset = m_texturesFrames[animationPhase][frameIndex].offset;
+    Point textureOffset2 = m_texturesFrames[animationPhase][frameIndex2].offset;
+    Rect textureRect = m_texturesFrames[animationPhase][frameIndex].rect;
+    Rect textureRect2 = m_texturesFrames[animationPhase][frameIndex2].rect;
     Size size = textureRect.size();
     if (!size.isValid())
         return nullptr;
@@ -623,16 +730,16 @@ Rect ThingType::getDrawSize(const Point& dest, int layer, int xPattern, int yPat
     if (animationPhase < 0 || animationPhase >= m_animationPhases)
         return Rect(0, 0, 1, 1);
 
-    const TexturePtr& texture = getTexture(animationPhase); // texture might not exists, neither its rects.
+    TexturePtr texture = getTexture(animationPhase); // texture might not exists, neither its rects.
     if (!texture)
         return Rect(0, 0, 1, 1);
 
     uint frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
-    if (frameIndex >= m_texturesFramesRects[animationPhase].size())
+    if (frameIndex >= m_texturesFrames[animationPhase].size())
         return Rect(0, 0, 1, 1);
 
-    Point textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    Rect textureRect = m_texturesFramesRects[animationPhase][frameIndex];
+    Point textureOffset = m_texturesFrames[animationPhase][frameIndex].offset;
+    Rect textureRect = m_texturesFrames[animationPhase][frameIndex].rect;
     return Rect(dest + textureOffset - m_displacement - (m_size.toPoint() - Point(1, 1)) * g_sprites.spriteSize(), textureRect.size());
 }
 
@@ -644,16 +751,16 @@ void ThingType::drawWithShader(const Point& dest, int layer, int xPattern, int y
     if (animationPhase < 0 || animationPhase >= m_animationPhases)
         return;
 
-    const TexturePtr& texture = getTexture(animationPhase); // texture might not exists, neither its rects.
+    TexturePtr texture = getTexture(animationPhase); // texture might not exists, neither its rects.
     if (!texture)
         return;
 
     uint frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
-    if (frameIndex >= m_texturesFramesRects[animationPhase].size())
+    if (frameIndex >= m_texturesFrames[animationPhase].size())
         return;
 
-    Point textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    Rect textureRect = m_texturesFramesRects[animationPhase][frameIndex];
+    Point textureOffset = m_texturesFrames[animationPhase][frameIndex].offset;
+    Rect textureRect = m_texturesFrames[animationPhase][frameIndex].rect;
 
     Rect screenRect(dest + (textureOffset - m_displacement * g_sprites.getOffsetFactor() - (m_size.toPoint() - Point(1, 1)) * g_sprites.spriteSize()), textureRect.size());
 
@@ -678,16 +785,16 @@ void ThingType::drawWithShader(const Rect& dest, int layer, int xPattern, int yP
     if (animationPhase < 0 || animationPhase >= m_animationPhases)
         return;
 
-    const TexturePtr& texture = getTexture(animationPhase); // texture might not exists, neither its rects.
+    TexturePtr texture = getTexture(animationPhase); // texture might not exists, neither its rects.
     if (!texture)
         return;
 
     uint frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
-    if (frameIndex >= m_texturesFramesRects[animationPhase].size())
+    if (frameIndex >= m_texturesFrames[animationPhase].size())
         return;
 
-    Point textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    Rect textureRect = m_texturesFramesRects[animationPhase][frameIndex];
+    Point textureOffset = m_texturesFrames[animationPhase][frameIndex].offset;
+    Rect textureRect = m_texturesFrames[animationPhase][frameIndex].rect;
 
     bool useOpacity = m_opacity < 1.0f;
     if (useOpacity)
@@ -714,10 +821,18 @@ void ThingType::drawWithShader(const Rect& dest, int layer, int xPattern, int yP
     //return g_drawQueue->addTexturedRect(Rect(dest.topLeft() + (textureOffset * scale), textureRect.size() * scale), texture, textureRect, color);
 }
 
-const TexturePtr& ThingType::getTexture(int animationPhase)
+TexturePtr ThingType::getTexture(int animationPhase)
 {
+    // items and outfits in the ui may be drawn while the map is built on another thread
+    std::lock_guard<std::mutex> lock(m_texturesMutex);
+
     m_lastUsage = g_clock.seconds();
 
+    if(m_textures.empty()) {
+        m_textures.resize(m_animationPhases);
+        m_texturesFrames.resize(m_animationPhases);
+    }
+
     int spriteSize = g_sprites.spriteSize();
     TexturePtr& animationPhaseTexture = m_textures[animationPhase];
     if(!animationPhaseTexture) {
@@ -743,9 +858,7 @@ const TexturePtr& ThingType::getTexture(int animationPhase)
         else
             fullImage = ImagePtr(new Image(textureSize * spriteSize));
 
-        m_texturesFramesRects[animationPhase].resize(indexSize);
-        m_texturesFramesOriginRects[animationPhase].resize(indexSize);
-        m_texturesFramesOffsets[animationPhase].resize(indexSize);
+        m_texturesFrames[animationPhase].resize(indexSize);
 
         for(int z = 0; z < m_numPatternZ; ++z) {
             for(int y = 0; y < m_numPatternY; ++y) {
@@ -784,9 +897,9 @@ const TexturePtr& ThingType::getTexture(int animationPhase)
                             }
                         }
 
-                        m_texturesFramesRects[animationPhase][frameIndex] = drawRect;
-                        m_texturesFramesOriginRects[animationPhase][frameIndex] = Rect(framePos, Size(m_size.width(), m_size.height()) * spriteSize);// *0.5;
-                        m_texturesFramesOffsets[animationPhase][frameIndex] = (drawRect.topLeft() - framePos);
+                        m_texturesFrames[animationPhase][frameIndex].rect = drawRect;
+                        m_texturesFrames[animationPhase][frameIndex].originRect = Rect(framePos, Size(m_size.width(), m_size.height()) * spriteSize);// *0.5;
+                        m_texturesFrames[animationPhase][frameIndex].offset = (drawRect.topLeft() - framePos);
                     }
                 }
             }
@@ -857,16 +970,43 @@ int ThingType::getExactSize(int layer, int xPattern, int yPattern, int zPattern,
 
     getTexture(animationPhase); // we must calculate it anyway.
     int frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
-    Size size = m_texturesFramesOriginRects[animationPhase][frameIndex].size() - m_texturesFramesOffsets[animationPhase][frameIndex].toSize();
+    Size size = m_texturesFrames[animationPhase][frameIndex].originRect.size() - m_texturesFrames[animationPhase][frameIndex].offset.toSize();
     return std::max<int>(size.width(), size.height());
 }
 
 void ThingType::setPathable(bool var)
 {
-    if(var == true)
-        m_attribs.remove(ThingAttrNotPathable);
-    else
-        m_attribs.set(ThingAttrNotPathable, true);
+    m_flags.set(ThingAttrNotPathable, !var);
+}
+
+uint16* ThingType::getAttrValue(int attr)
+{
+    switch(attr) {
+        case ThingAttrGround: return &m_groundSpeed;
+        case ThingAttrWritable: return &m_writableLength;
+        case ThingAttrWritableOnce: return &m_writableOnceLength;
+        case ThingAttrMinimapColor: return &m_minimapColor;
+        case ThingAttrCloth: return &m_clothSlot;
+        case ThingAttrLensHelp: return &m_lensHelp;
+        case ThingAttrUsable: return &m_usable;
+        default: return nullptr;
+    }
+}
+
+size_t ThingType::getMemoryUsage()
+{
+    // heap owned by this type, textures themselves live in video memory
+    size_t usage = sizeof(ThingType);
+    usage += m_spritesIndex.capacity() * sizeof(int);
+    usage += m_bones.capacity() * sizeof(Point);
+    usage += m_customImage.capacity();
+    if(m_marketData)
+        usage += sizeof(MarketData) + m_marketData->name.capacity();
+    usage += m_textures.capacity() * sizeof(TexturePtr);
+    usage += m_texturesFrames.capacity() * sizeof(std::vector<TextureFrame>);
+    for(const auto& frames : m_texturesFrames)
+        usage += frames.capacity() * sizeof(TextureFrame);
+    return usage;
 }
 
 void DrawQueueItemThingWithShader::draw()
@@ -34,6 +34,8 @@
 #include <framework/luaengine/luaobject.h>
 #include <framework/net/server.h>
 
+#include <bitset>
+
 enum NewDrawType : uint8 {
     NewDrawNormal = 0,
     NewDrawMount = 5,
@@ -152,6 +154,12 @@ struct Imbuement {
     int protectionCost;
 };
 
+struct TextureFrame {
+    Rect rect;
+    Rect originRect;
+    Point offset;
+};
+
 struct Light {
     Point pos;
     uint8_t color = 215;
@@ -172,10 +180,18 @@ public:
     ThingType();
 
     void unserialize(uint16 clientId, ThingCategory category, const FileStreamPtr& fin);
+    // maps an attribute as stored in the .dat of the current client version to ThingAttr
+    static int normalizeDatAttr(int attr);
+    // maps a ThingAttr back to its .dat value, -1 if the current client version has none
+    static int denormalizeDatAttr(int attr);
+    // moves fin past one .dat entry without parsing it
+    static void skipDatEntry(ThingCategory category, const FileStreamPtr& fin);
     void unserializeOtml(const OTMLNodePtr& node);
     void unload();
 
     void serialize(const FileStreamPtr& fin);
+    // compares everything serialize writes, used to verify saved files
+    bool isSameDatEntry(const ThingTypePtr& other);
     void exportImage(std::string fileName);
     void replaceSprites(std::map<uint32_t, ImagePtr>& replacements, std::string fileName);
 
@@ -189,9 +205,10 @@ public:
     uint16 getId() { return m_id; }
     ThingCategory getCategory() { return m_category; }
     bool isNull() { return m_null; }
-    bool hasAttr(ThingAttr attr) { return m_attribs.has(attr); }
+    bool hasAttr(ThingAttr attr) { return m_flags.test(attr); }
     bool isLoaded() { return m_loaded; }
     ticks_t getLastUsage() { return m_lastUsage; }
+    size_t getMemoryUsage();
 
     Size getSize() { return m_size; }
     int getWidth() { return m_size.width(); }
@@ -211,71 +228,83 @@ public:
     int getElevation() { return m_elevation; }
     const Point& getBones(int direction) { return m_bones[direction]; }
 
-    int getGroundSpeed() { return m_attribs.get<uint16>(ThingAttrGround); }
-    int getMaxTextLength() { return m_attribs.has(ThingAttrWritableOnce) ? m_attribs.get<uint16>(ThingAttrWritableOnce) : m_attribs.get<uint16>(ThingAttrWritable); }
-    Light getLight() { return m_attribs.get<Light>(ThingAttrLight); }
-    int getMinimapColor() { return m_attribs.get<uint16>(ThingAttrMinimapColor); }
-    int getLensHelp() { return m_attribs.get<uint16>(ThingAttrLensHelp); }
-    int getClothSlot() { return m_attribs.get<uint16>(ThingAttrCloth); }
-    MarketData getMarketData() { return m_attribs.get<MarketData>(ThingAttrMarket); }
-    bool isGround() { return m_attribs.has(ThingAttrGround); }
-    bool isGroundBorder() { return m_attribs.has(ThingAttrGroundBorder); }
-    bool isOnBottom() { return m_attribs.has(ThingAttrOnBottom); }
-    bool isOnTop() { return m_attribs.has(ThingAttrOnTop); }
-    bool isContainer() { return m_attribs.has(ThingAttrContainer); }
-    bool isStackable() { return m_attribs.has(ThingAttrStackable); }
-    bool isForceUse() { return m_attribs.has(ThingAttrForceUse); }
-    bool isMultiUse() { return m_attribs.has(ThingAttrMultiUse); }
-    bool isWritable() { return m_attribs.has(ThingAttrWritable); }
-    bool isChargeable() { return m_attribs.has(ThingAttrChargeable); }
-    bool isWritableOnce() { return m_attribs.has(ThingAttrWritableOnce); }
-    bool isFluidContainer() { return m_attribs.has(ThingAttrFluidContainer); }
-    bool isSplash() { return m_attribs.has(ThingAttrSplash); }
-    bool isNotWalkable() { return m_attribs.has(ThingAttrNotWalkable); }
-    bool isNotMoveable() { return m_attribs.has(ThingAttrNotMoveable); }
-    bool blockProjectile() { return m_attribs.has(ThingAttrBlockProjectile); }
-    bool isNotPathable() { return m_attribs.has(ThingAttrNotPathable); }
-    bool isPickupable() { return m_attribs.has(ThingAttrPickupable); }
-    bool isHangable() { return m_attribs.has(ThingAttrHangable); }
-    bool isHookSouth() { return m_attribs.has(ThingAttrHookSouth); }
-    bool isHookEast() { return m_attribs.has(ThingAttrHookEast); }
-    bool isRotateable() { return m_attribs.has(ThingAttrRotateable); }
-    bool hasLight() { return m_attribs.has(ThingAttrLight); }
-    bool isDontHide() { return m_attribs.has(ThingAttrDontHide); }
-    bool isTranslucent() { return m_attribs.has(ThingAttrTranslucent); }
-    bool hasDisplacement() { return m_attribs.has(ThingAttrDisplacement); }
-    bool hasElevation() { return m_attribs.has(ThingAttrElevation); }
-    bool isLyingCorpse() { return m_attribs.has(ThingAttrLyingCorpse); }
-    bool isAnimateAlways() { return m_attribs.has(ThingAttrAnimateAlways); }
-    bool hasMiniMapColor() { return m_attribs.has(ThingAttrMinimapColor); }
-    bool hasLensHelp() { return m_attribs.has(ThingAttrLensHelp); }
-    bool isFullGround() { return m_attribs.has(ThingAttrFullGround); }
-    bool isIgnoreLook() { return m_attribs.has(ThingAttrLook); }
-    bool isCloth() { return m_attribs.has(ThingAttrCloth); }
-    bool isMarketable() { return m_attribs.has(ThingAttrMarket); }
-    bool isUsable() { return m_attribs.has(ThingAttrUsable); }
-    bool isWrapable() { return m_attribs.has(ThingAttrWrapable); }
-    bool isUnwrapable() { return m_attribs.has(ThingAttrUnwrapable); }
-    bool isTopEffect() { return m_attribs.has(ThingAttrTopEffect); }
-    bool hasBones() { return m_attribs.has(ThingAttrBones); }
+    int getGroundSpeed() { return m_groundSpeed; }
+    int getMaxTextLength() { return hasAttr(ThingAttrWritableOnce) ? m_writableOnceLength : m_writableLength; }
+    Light getLight() { return m_light; }
+    int getMinimapColor() { return m_minimapColor; }
+    int getLensHelp() { return m_lensHelp; }
+    int getClothSlot() { return m_clothSlot; }
+    MarketData getMarketData() { return m_marketData ? *m_marketData : MarketData(); }
+    bool isGround() { return hasAttr(ThingAttrGround); }
+    bool isGroundBorder() { return hasAttr(ThingAttrGroundBorder); }
+    bool isOnBottom() { return hasAttr(ThingAttrOnBottom); }
+    bool isOnTop() { return hasAttr(ThingAttrOnTop); }
+    bool isContainer() { return hasAttr(ThingAttrContainer); }
+    bool isStackable() { return hasAttr(ThingAttrStackable); }
+    bool isForceUse() { return hasAttr(ThingAttrForceUse); }
+    bool isMultiUse() { return hasAttr(ThingAttrMultiUse); }
+    bool isWritable() { return hasAttr(ThingAttrWritable); }
+    bool isChargeable() { return hasAttr(ThingAttrChargeable); }
+    bool isWritableOnce() { return hasAttr(ThingAttrWritableOnce); }
+    bool isFluidContainer() { return hasAttr(ThingAttrFluidContainer); }
+    bool isSplash() { return hasAttr(ThingAttrSplash); }
+    bool isNotWalkable() { return hasAttr(ThingAttrNotWalkable); }
+    bool isNotMoveable() { return hasAttr(ThingAttrNotMoveable); }
+    bool blockProjectile() { return hasAttr(ThingAttrBlockProjectile); }
+    bool isNotPathable() { return hasAttr(ThingAttrNotPathable); }
+    bool isPickupable() { return hasAttr(ThingAttrPickupable); }
+    bool isHangable() { return hasAttr(ThingAttrHangable); }
+    bool isHookSouth() { return hasAttr(ThingAttrHookSouth); }
+    bool isHookEast() { return hasAttr(ThingAttrHookEast); }
+    bool isRotateable() { return hasAttr(ThingAttrRotateable); }
+    bool hasLight() { return hasAttr(ThingAttrLight); }
+    bool isDontHide() { return hasAttr(ThingAttrDontHide); }
+    bool isTranslucent() { return hasAttr(ThingAttrTranslucent); }
+    bool hasDisplacement() { return hasAttr(ThingAttrDisplacement); }
+    bool hasElevation() { return hasAttr(ThingAttrElevation); }
+    bool isLyingCorpse() { return hasAttr(ThingAttrLyingCorpse); }
+    bool isAnimateAlways() { return hasAttr(ThingAttrAnimateAlways); }
+    bool hasMiniMapColor() { return hasAttr(ThingAttrMinimapColor); }
+    bool hasLensHelp() { return hasAttr(ThingAttrLensHelp); }
+    bool isFullGround() { return hasAttr(ThingAttrFullGround); }
+    bool isIgnoreLook() { return hasAttr(ThingAttrLook); }
+    bool isCloth() { return hasAttr(ThingAttrCloth); }
+    bool isMarketable() { return hasAttr(ThingAttrMarket); }
+    bool isUsable() { return hasAttr(ThingAttrUsable); }
+    bool isWrapable() { return hasAttr(ThingAttrWrapable); }
+    bool isUnwrapable() { return hasAttr(ThingAttrUnwrapable); }
+    bool isTopEffect() { return hasAttr(ThingAttrTopEffect); }
+    bool hasBones() { return hasAttr(ThingAttrBones); }
 
     std::vector<int> getSprites() { return m_spritesIndex; }
 
     // additional
     float getOpacity() { return m_opacity; }
-    bool isNotPreWalkable() { return m_attribs.has(ThingAttrNotPreWalkable); }
+    bool isNotPreWalkable() { return hasAttr(ThingAttrNotPreWalkable); }
     void setPathable(bool var);
 
 private:
-    const TexturePtr& getTexture(int animationPhase);
+    TexturePtr getTexture(int animationPhase);
     Size getBestTextureDimension(int w, int h, int count);
     uint getSpriteIndex(int w, int h, int l, int x, int y, int z, int a);
     uint getTextureIndex(int l, int x, int y, int z);
+    uint16* getAttrValue(int attr);
 
     ThingCategory m_category;
     uint16 m_id;
     bool m_null;
-    stdext::dynamic_storage<uint8> m_attribs;
+    std::bitset<ThingLastAttr> m_flags;
+
+    // values of the few attributes that carry one, the rest are plain flags
+    uint16 m_groundSpeed = 0;
+    uint16 m_writableLength = 0;
+    uint16 m_writableOnceLength = 0;
+    uint16 m_minimapColor = 0;
+    uint16 m_clothSlot = 0;
+    uint16 m_lensHelp = 0;
+    uint16 m_usable = 0;
+    Light m_light;
+    std::unique_ptr<MarketData> m_marketData;
 
     Size m_size;
     Point m_displacement;
@@ -292,10 +321,10 @@ private:
     std::string m_customImage;
 
     std::vector<int> m_spritesIndex;
+    // allocated on first use of a texture, most types are never drawn
     std::vector<TexturePtr> m_textures;
-    std::vector<std::vector<Rect>> m_texturesFramesRects;
-    std::vector<std::vector<Rect>> m_texturesFramesOriginRects;
-    std::vector<std::vector<Point>> m_texturesFramesOffsets;
+    std::vector<std::vector<TextureFrame>> m_texturesFrames;
+    std::mutex m_texturesMutex;
 
     bool m_loaded = false;
     time_t m_lastUsage;
@@ -313,6 +342,10 @@ struct DrawQueueItemThingWithShader : public DrawQueueItemTexturedRect {
     {
         return false;
     }
+    bool hash(uint64_t& hash, Rect& dest) override
+    {
+        return false; // shaders animate on their own
+    }
 
     Point m_offset;
     Point m_center;
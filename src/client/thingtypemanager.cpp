@@ -31,10 +31,12 @@
 
 #include <framework/core/resourcemanager.h>
 #include <framework/core/filestream.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/binarytree.h>
 #include <framework/xml/tinyxml.h>
 #include <framework/otml/otml.h>
 #include <framework/util/stats.h>
+#include <framework/platform/platform.h>
 
 ThingTypeManager g_things;
 
@@ -123,6 +125,36 @@ void ThingTypeManager::saveDat(std::string fileName)
         fin->close();
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to save '%s': %s", fileName, e.what()));
+        return;
+    }
+
+    // read the file back, every entry must load as the type it was saved from
+    try {
+        FileStreamPtr fin = g_resources.openFile(fileName, true);
+        if(fin->getU32() != m_datSignature)
+            stdext::throw_exception("signature mismatch");
+
+        int counts[ThingLastCategory];
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            counts[category] = fin->getU16() + 1;
+            if(counts[category] != (int)m_thingTypes[category].size())
+                stdext::throw_exception(stdext::format("count mismatch in category %d", category));
+        }
+
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            uint16 firstId = 1;
+            if(category == ThingCategoryItem)
+                firstId = 100;
+
+            for(uint16 id = firstId; id < counts[category]; ++id) {
+                ThingTypePtr type(new ThingType);
+                type->unserialize(id, (ThingCategory)category, fin);
+                if(!type->isSameDatEntry(m_thingTypes[category][id]))
+                    stdext::throw_exception(stdext::format("entry %d in category %d differs", id, category));
+            }
+        }
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Saved '%s' does not load back: %s", fileName, e.what()));
     }
 }
 
@@ -169,6 +201,7 @@ void ThingTypeManager::replaceTextures(std::string dir) {
 
 bool ThingTypeManager::loadDat(std::string file)
 {
+    ticks_t start = stdext::millis();
     m_datLoaded = false;
     m_datSignature = 0;
     m_contentRevision = 0;
@@ -186,16 +219,80 @@ bool ThingTypeManager::loadDat(std::string file)
             m_thingTypes[category].resize(count, m_nullThingType);
         }
 
-        m_marketCategories.clear();
+        // find where each entry starts first, then parse them in parallel, each
+        // worker reading through its own view of the file data
+        struct DatEntry {
+            ThingCategory category;
+            uint16 id;
+            uint32 offset;
+        };
+        std::vector<DatEntry> entries;
         for(int category = 0; category < ThingLastCategory; ++category) {
             uint16 firstId = 1;
             if(category == ThingCategoryItem)
                 firstId = 100;
             for(uint16 id = firstId; id < m_thingTypes[category].size(); ++id) {
-                ThingTypePtr type(new ThingType);
-                type->unserialize(id, (ThingCategory)category, fin);
-                m_thingTypes[category][id] = type;
-                if (type->isMarketable()) {
+                entries.push_back(DatEntry{ (ThingCategory)category, id, fin->tell() });
+                ThingType::skipDatEntry((ThingCategory)category, fin);
+            }
+        }
+
+        struct DatBatch {
+            std::atomic<size_t> next;
+            size_t done = 0;
+            std::string error;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto batch = std::make_shared<DatBatch>();
+        batch->next = 0;
+
+        const size_t entriesPerChunk = 512;
+        size_t chunks = (entries.size() + entriesPerChunk - 1) / entriesPerChunk;
+        auto work = [this, batch, &entries, chunks](const FileStreamPtr& stream) {
+            size_t chunk;
+            while((chunk = batch->next++) < chunks) {
+                std::string error;
+                try {
+                    size_t end = std::min<size_t>(entries.size(), (chunk + 1) * entriesPerChunk);
+                    for(size_t i = chunk * entriesPerChunk; i < end; ++i) {
+                        const DatEntry& entry = entries[i];
+                        stream->seek(entry.offset);
+                        ThingTypePtr type(new ThingType);
+                        type->unserialize(entry.id, entry.category, stream);
+                        m_thingTypes[entry.category][entry.id] = type;
+                    }
+                } catch(stdext::exception& e) {
+                    error = e.what();
+                }
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                if(batch->error.empty())
+                    batch->error = error;
+                if(++batch->done == chunks)
+                    batch->finished.notify_all();
+            }
+        };
+
+        // uncached files can only be read through one stream
+        if(fin->createView()) {
+            size_t workers = std::min<size_t>(3, chunks > 0 ? chunks - 1 : 0);
+            for(size_t i = 0; i < workers; ++i)
+                g_asyncDispatcher.dispatch([work, fin] { work(fin->createView()); });
+        }
+        work(fin);
+
+        {
+            // entries is used by the workers until every chunk is done
+            std::unique_lock<std::mutex> lock(batch->mutex);
+            batch->finished.wait(lock, [&] { return batch->done == chunks; });
+            if(!batch->error.empty())
+                stdext::throw_exception(batch->error);
+        }
+
+        m_marketCategories.clear();
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            for(const ThingTypePtr& type : m_thingTypes[category]) {
+                if(type->isMarketable()) {
                     auto marketData = type->getMarketData();
                     m_marketCategories.insert(marketData.category);
                 }
@@ -203,6 +300,11 @@ bool ThingTypeManager::loadDat(std::string file)
         }
 
         m_datLoaded = true;
+        size_t types = 0;
+        for(int category = 0; category < ThingLastCategory; ++category)
+            types += m_thingTypes[category].size();
+        g_logger.info(stdext::format("Loaded dat '%s': %d types in %d ms, thing types use %.1f MB, process rss %.1f MB", file, (int)types,
+                                     (int)(stdext::millis() - start), getMemoryUsage() / 1048576.0, g_platform.getMemoryUsage() / 1048576.0));
         g_lua.callGlobalField("g_things", "onLoadDat", file);
         return true;
     } catch(stdext::exception& e) {
@@ -450,6 +552,19 @@ ItemTypeList ThingTypeManager::findItemTypesByString(std::string name)
     return ret;
 }
 
+uint64 ThingTypeManager::getMemoryUsage()
+{
+    uint64 usage = 0;
+    for(int category = ThingCategoryItem; category < ThingLastCategory; ++category) {
+        usage += m_thingTypes[category].capacity() * sizeof(ThingTypePtr);
+        for(const ThingTypePtr& type : m_thingTypes[category]) {
+            if(type != m_nullThingType)
+                usage += type->getMemoryUsage();
+        }
+    }
+    return usage;
+}
+
 const ThingTypePtr& ThingTypeManager::getThingType(uint16 id, ThingCategory category)
 {
     if(category >= ThingLastCategory || id >= m_thingTypes[category].size()) {
@@ -80,6 +80,8 @@ public:
     const ThingTypeList& getThingTypes(ThingCategory category);
     const ItemTypeList& getItemTypes() { return m_itemTypes; }
 
+    uint64 getMemoryUsage();
+
     uint32 getDatSignature() { return m_datSignature; }
     uint32 getOtbMajorVersion() { return m_otbMajorVersion; }
     uint32 getOtbMinorVersion() { return m_otbMinorVersion; }
@@ -57,7 +57,9 @@ bool UIMap::onMouseMove(const Point& mousePos, const Point& mouseMoved)
 
 void UIMap::drawSelf(Fw::DrawPane drawPane)
 {
-    VALIDATE_DISPATCHER_THREAD();
+    // the map background may be built on the map pass thread while the dispatcher builds the ui
+    if (drawPane != Fw::MapBackgroundPane)
+        VALIDATE_DISPATCHER_THREAD();
     UIWidget::drawSelf(drawPane);
 
     if(drawPane == Fw::ForegroundPane) {
@@ -1,42 +1,85 @@
 #include <framework/core/logger.h>
 #include <framework/core/graphicalapplication.h>
+#include <framework/platform/platformwindow.h>
 #include <framework/stdext/format.h>
 #include <framework/util/extras.h>
 
 #include "adaptiverenderer.h"
 
+#include <iomanip>
+
 AdaptiveRenderer g_adaptiveRenderer;
 
+namespace {
+const char* phaseNames[AdaptiveRenderer::PhasesCount] = { "map", "creatures", "texts", "lights", "ui" };
+}
+
 void AdaptiveRenderer::newFrame() {
-    auto now = stdext::millis();
-    m_frames.push_back(now);
-    while (m_frames.front() + 5000 < now) {
-        m_frames.pop_front();
-    }
+    m_frames += 1;
 
     if (m_forcedSpeed >= 0 && m_forcedSpeed <= 4) {
-        m_speed = m_forcedSpeed;
-        return;
+        for (auto& level : m_levels)
+            level = m_forcedSpeed.load();
     }
 
-    if (m_update + 5000 > now)
+    auto now = stdext::millis();
+    if (m_update + 250 > now)
         return;
 
-    m_update = stdext::millis();
+    update(now);
+    m_update = now;
+}
 
-    if (m_speed < 1)
-        m_speed = 1;
+void AdaptiveRenderer::update(ticks_t now) {
+    std::lock_guard<std::mutex> lock(m_mutex);
 
     int maxFps = std::min<int>(100, std::max<int>(10, g_app.getMaxFps() < 10 ? 100 : g_app.getMaxFps()));
-    if (m_speed >= 2 && maxFps > 60) { // fix for forced vsync
+    if (g_window.hasVerticalSync() && maxFps > 60) { // fix for forced vsync
         maxFps = 60;
     }
-
-    if (m_frames.size() < maxFps * (4.0f - m_speed * 0.3f) && m_speed != RenderSpeeds - 1) {
-        m_speed += 1;
+    m_targetFrameTime = 1000.f / maxFps;
+
+    // costs are per rendered frame, so a phase skipped in some frames costs less
+    int frames = std::max(1, m_frames);
+    m_frames = 0;
+    float total = 0;
+    for (int i = 0; i < PhasesCount; ++i) {
+        float cost = m_phaseTime[i].exchange(0) / 1000.f / frames;
+        m_costs[i] = m_costs[i] * 0.7f + cost * 0.3f;
+        total += m_costs[i];
     }
-    if (m_frames.size() > maxFps * (4.5f - m_speed * 0.1f) && m_speed > 1) {
-        m_speed -= 1;
+
+    if (m_forcedSpeed >= 0 && m_forcedSpeed <= 4)
+        return;
+
+    // hysteresis, quality is lowered over the budget and raised only well below it, one phase at a time
+    // and never right after the phase changed, raising waits longer than lowering
+    if (total > m_targetFrameTime) {
+        // the most expensive phase which can still get cheaper
+        int phase = -1;
+        for (int i = 0; i < PhasesCount; ++i) {
+            if (m_levels[i] >= RenderSpeeds - 1 || m_levelChanged[i] + 1000 > now)
+                continue;
+            if (phase < 0 || m_costs[i] > m_costs[phase])
+                phase = i;
+        }
+        if (phase >= 0) {
+            m_levels[phase] += 1;
+            m_levelChanged[phase] = now;
+        }
+    } else if (total < m_targetFrameTime * 0.6f) {
+        // the most degraded phase, if it still fits when its cost doubles
+        int phase = -1;
+        for (int i = 0; i < PhasesCount; ++i) {
+            if (m_levels[i] <= 0 || m_levelChanged[i] + 3000 > now)
+                continue;
+            if (phase < 0 || m_levels[i] > m_levels[phase])
+                phase = i;
+        }
+        if (phase >= 0 && total + m_costs[phase] < m_targetFrameTime * 0.8f) {
+            m_levels[phase] -= 1;
+            m_levelChanged[phase] = now;
+        }
     }
 }
 
@@ -44,48 +87,87 @@ void AdaptiveRenderer::refresh() {
     m_update = stdext::millis();
 }
 
+void AdaptiveRenderer::addPhaseTime(Phase phase, ticks_t micros) {
+    m_phaseTime[phase] += micros;
+}
+
 int AdaptiveRenderer::effetsLimit() {
     static int limits[RenderSpeeds] = { 20, 10, 7, 4, 2 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseMap]];
 }
 
 int AdaptiveRenderer::creaturesLimit() {
     static int limits[RenderSpeeds] = { 20, 10, 7, 5, 3 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseCreatures]];
 }
 
 int AdaptiveRenderer::itemsLimit() {
     static int limits[RenderSpeeds] = { 20, 10, 7, 5, 3 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseMap]];
 }
 
 int AdaptiveRenderer::mapRenderInterval() {
     static int limits[RenderSpeeds] = { 0, 10, 20, 50, 100 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseMap]];
 }
 
 int AdaptiveRenderer::textsLimit() {
     static int limits[RenderSpeeds] = { 1000, 50, 30, 15, 5 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseTexts]];
 }
 
 int AdaptiveRenderer::creaturesRenderInterval() {
     // not working yet
     static int limits[RenderSpeeds] = { 0, 0, 10, 15, 20 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseCreatures]];
+}
+
+int AdaptiveRenderer::lightsLimit() {
+    static int limits[RenderSpeeds] = { 1000, 300, 150, 75, 30 };
+    return limits[m_levels[PhaseLights]];
 }
 
 bool AdaptiveRenderer::allowFading() {
-    return m_speed <= 2;
+    return m_levels[PhaseMap] <= 2;
+}
+
+int AdaptiveRenderer::getLevel() {
+    int level = 0;
+    for (auto& phaseLevel : m_levels)
+        level = std::max<int>(level, phaseLevel);
+    return level;
 }
 
 int AdaptiveRenderer::foregroundUpdateInterval() {
     static int limits[RenderSpeeds] = { 0, 20, 40, 50, 60 };
-    return limits[m_speed];
+    return limits[m_levels[PhaseUI]];
 }
 
 std::string AdaptiveRenderer::getDebugInfo() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     std::stringstream ss;
-    ss << "Frames: " << m_frames.size() << "|" << m_speed << "|" << m_forcedSpeed;
+    ss << std::fixed << std::setprecision(1) << "Target: " << m_targetFrameTime << "ms|" << m_forcedSpeed;
+    for (int i = 0; i < PhasesCount; ++i)
+        ss << "|" << phaseNames[i] << " " << m_costs[i] << "ms " << m_levels[i];
     return ss.str();
-}
\ No newline at end of file
+}
+
+float AdaptiveRenderer::getTargetFrameTime() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_targetFrameTime;
+}
+
+std::map<std::string, int> AdaptiveRenderer::getPhaseLevels() {
+    std::map<std::string, int> levels;
+    for (int i = 0; i < PhasesCount; ++i)
+        levels[phaseNames[i]] = m_levels[i];
+    return levels;
+}
+
+std::map<std::string, double> AdaptiveRenderer::getPhaseCosts() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<std::string, double> costs;
+    for (int i = 0; i < PhasesCount; ++i)
+        costs[phaseNames[i]] = m_costs[i];
+    return costs;
+}
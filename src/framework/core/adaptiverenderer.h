@@ -1,16 +1,35 @@
 #ifndef ADAPTIVERENDERER_H
 #define ADAPTIVERENDERER_H
 
-#include <list>
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <framework/stdext/types.h>
 
 constexpr int RenderSpeeds = 5;
 
+// every phase of a frame has its own quality level (0 is the best), the cost of each phase is measured
+// and the levels are adjusted one at a time to keep the frame within the time of the fps limit
 class AdaptiveRenderer {
 public:
+    enum Phase {
+        PhaseMap = 0,
+        PhaseCreatures,
+        PhaseTexts,
+        PhaseLights,
+        PhaseUI,
+        PhasesCount
+    };
+
     void newFrame();
 
     void refresh();
 
+    // thread safe, adds the time spent in a phase during the current frame
+    void addPhaseTime(Phase phase, ticks_t micros);
+
     int effetsLimit();
 
     int creaturesLimit();
@@ -19,6 +38,8 @@ public:
 
     int textsLimit();
 
+    int lightsLimit();
+
     int mapRenderInterval();
 
     int creaturesRenderInterval();
@@ -26,9 +47,7 @@ public:
 
     bool allowFading();
 
-    int getLevel() {
-        return m_speed;
-    }
+    int getLevel();
 
     int foregroundUpdateInterval();
 
@@ -38,13 +57,26 @@ public:
         m_forcedSpeed = value;
     }
 
+    float getTargetFrameTime();
+    std::map<std::string, int> getPhaseLevels();
+    std::map<std::string, double> getPhaseCosts();
+
 private:
-    int m_forcedSpeed = -1;
-    int m_speed = 0;
-    time_t m_update = 0;
-    std::list<time_t> m_frames;
+    void update(ticks_t now);
+
+    std::atomic_int m_forcedSpeed = -1;
+    ticks_t m_update = 0;
+
+    int m_frames = 0;
+    std::atomic<int64_t> m_phaseTime[PhasesCount] = {};
+
+    std::mutex m_mutex;
+    std::array<std::atomic_int, PhasesCount> m_levels = {};
+    std::array<float, PhasesCount> m_costs = {}; // milliseconds per pass, smoothed
+    std::array<ticks_t, PhasesCount> m_levelChanged = {};
+    float m_targetFrameTime = 0;
 };
 
 extern AdaptiveRenderer g_adaptiveRenderer;
 
-#endif
\ No newline at end of file
+#endif
@@ -46,9 +46,25 @@ FileStream::FileStream(const std::string& name, std::string&& buffer) :
 {
     if (!initFromGzip(buffer)) {
         m_strData = std::move(buffer);
+        if (!m_strData.empty()) {
+            m_viewData = (const uint8*)m_strData.data();
+            m_viewSize = m_strData.size();
+        }
     }
 }
 
+FileStream::FileStream(const std::string& name, const uint8* data, uint size, const std::shared_ptr<void>& dataOwner) :
+    m_name(name),
+    m_fileHandle(nullptr),
+    m_pos(0),
+    m_writeable(false),
+    m_caching(true),
+    m_viewData(size > 0 ? data : nullptr),
+    m_viewSize(size),
+    m_viewOwner(dataOwner)
+{
+}
+
 bool FileStream::initFromGzip(const std::string& buffer)
 {
     if (buffer.size() < 10 || (uint8_t)buffer[0] != 0x1f ||
@@ -80,6 +96,15 @@ bool FileStream::initFromGzip(const std::string& buffer)
 }
 
 
+FileStreamPtr FileStream::createView()
+{
+    if (!m_caching || m_writeable)
+        return nullptr;
+    if (m_viewData)
+        return FileStreamPtr(new FileStream(m_name, m_viewData, m_viewSize, m_viewOwner));
+    return FileStreamPtr(new FileStream(m_name, m_data.data(), m_data.size(), nullptr));
+}
+
 FileStream::~FileStream()
 {
     VALIDATE(!g_app.isTerminated());
@@ -97,6 +122,9 @@ void FileStream::close()
 
     m_data.clear();
     m_strData.clear();
+    m_viewData = nullptr;
+    m_viewSize = 0;
+    m_viewOwner.reset();
     m_pos = 0;
 }
 
@@ -126,15 +154,15 @@ int FileStream::read(void* buffer, uint32 size, uint32 nmemb)
         if (res == -1)
             throwError("read failed", true);
         return res;
-    } if (!m_strData.empty()) {
+    } if (m_viewData) {
         int writePos = 0;
         uint8* outBuffer = (uint8*)buffer;
         for (uint i = 0; i < nmemb; ++i) {
-            if (m_pos + size > m_strData.size())
+            if (m_pos + size > m_viewSize)
                 return i;
 
             for (uint j = 0; j < size; ++j)
-                outBuffer[writePos++] = m_strData[m_pos++];
+                outBuffer[writePos++] = m_viewData[m_pos++];
         }
         return nmemb;
     } else {
@@ -151,6 +179,30 @@ int FileStream::read(void* buffer, uint32 size, uint32 nmemb)
     }
 }
 
+// reads without moving the stream position, safe to call from several threads
+int FileStream::readAt(uint32 pos, void* buffer, uint32 size)
+{
+    if (!m_caching) {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        PHYSFS_sint64 oldPos = PHYSFS_tell(m_fileHandle);
+        if (!PHYSFS_seek(m_fileHandle, pos))
+            throwError("seek failed", true);
+        int res = PHYSFS_readBytes(m_fileHandle, buffer, size);
+        PHYSFS_seek(m_fileHandle, oldPos);
+        if (res == -1)
+            throwError("read failed", true);
+        return res;
+    }
+
+    const uint8* data = m_viewData ? m_viewData : m_data.data();
+    uint32 dataSize = m_viewData ? m_viewSize : m_data.size();
+    if (pos >= dataSize)
+        return 0;
+    size = std::min<uint32>(size, dataSize - pos);
+    memcpy(buffer, data + pos, size);
+    return size;
+}
+
 void FileStream::write(const void *buffer, uint32 count)
 {
     if(!m_caching) {
@@ -168,8 +220,8 @@ void FileStream::seek(uint32 pos)
     if (!m_caching) {
         if (!PHYSFS_seek(m_fileHandle, pos))
             throwError("seek failed", true);
-    } else if(!m_strData.empty()) {
-        if (pos > m_strData.size())
+    } else if(m_viewData) {
+        if (pos > m_viewSize)
             throwError("seek failed");
         m_pos = pos;
     } else {
@@ -188,8 +240,8 @@ uint FileStream::size()
 {
     if (!m_caching)
         return PHYSFS_fileLength(m_fileHandle);
-    else if (!m_strData.empty())
-        return m_strData.size();
+    else if (m_viewData)
+        return m_viewSize;
     else
         return m_data.size();
 }
@@ -206,8 +258,8 @@ bool FileStream::eof()
 {
     if(!m_caching)
         return PHYSFS_eof(m_fileHandle);
-    else if (!m_strData.empty())
-        return m_pos >= m_strData.size();
+    else if (m_viewData)
+        return m_pos >= m_viewSize;
     else
         return m_pos >= m_data.size();
 }
@@ -218,11 +270,11 @@ uint8 FileStream::getU8()
     if(!m_caching) {
         if(PHYSFS_readBytes(m_fileHandle, &v, 1) != 1)
             throwError("read failed", true);
-    } else if (!m_strData.empty()) {
-        if (m_pos + 1 > m_strData.size())
+    } else if (m_viewData) {
+        if (m_pos + 1 > m_viewSize)
             throwError("read failed");
 
-        v = m_strData[m_pos];
+        v = m_viewData[m_pos];
         m_pos += 1;
     } else {
         if(m_pos+1 > m_data.size())
@@ -240,11 +292,11 @@ uint16 FileStream::getU16()
     if(!m_caching) {
         if(PHYSFS_readULE16(m_fileHandle, &v) == 0)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 2 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 2 > m_viewSize)
             throwError("read failed");
 
-        v = stdext::readULE16((const uint8_t*)&m_strData[m_pos]);
+        v = stdext::readULE16(&m_viewData[m_pos]);
         m_pos += 2;
     } else {
         if(m_pos+2 > m_data.size())
@@ -262,11 +314,11 @@ uint32 FileStream::getU32()
     if(!m_caching) {
         if(PHYSFS_readULE32(m_fileHandle, &v) == 0)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 4 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 4 > m_viewSize)
             throwError("read failed");
 
-        v = stdext::readULE32((const uint8_t*)&m_strData[m_pos]);
+        v = stdext::readULE32(&m_viewData[m_pos]);
         m_pos += 4;
     } else {
         if (m_pos + 4 > m_data.size())
@@ -284,10 +336,10 @@ uint64 FileStream::getU64()
     if(!m_caching) {
         if(PHYSFS_readULE64(m_fileHandle, (PHYSFS_uint64*)&v) == 0)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 8 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 8 > m_viewSize)
             throwError("read failed");
-        v = stdext::readULE64((const uint8_t*)&m_strData[m_pos]);
+        v = stdext::readULE64(&m_viewData[m_pos]);
         m_pos += 8;
     } else {
         if (m_pos + 8 > m_data.size())
@@ -304,11 +356,11 @@ int8 FileStream::get8()
     if(!m_caching) {
         if(PHYSFS_readBytes(m_fileHandle, &v, 1) != 1)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 1 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 1 > m_viewSize)
             throwError("read failed");
 
-        v = m_strData[m_pos];
+        v = m_viewData[m_pos];
         m_pos += 1;
     } else {
         if(m_pos+1 > m_data.size())
@@ -326,11 +378,11 @@ int16 FileStream::get16()
     if(!m_caching) {
         if(PHYSFS_readSLE16(m_fileHandle, &v) == 0)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 2 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 2 > m_viewSize)
             throwError("read failed");
 
-        v = stdext::readSLE16((const uint8_t*)&m_strData[m_pos]);
+        v = stdext::readSLE16(&m_viewData[m_pos]);
         m_pos += 2;
     } else {
         if (m_pos + 2 > m_data.size())
@@ -348,11 +400,11 @@ int32 FileStream::get32()
     if(!m_caching) {
         if(PHYSFS_readSLE32(m_fileHandle, &v) == 0)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 4 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 4 > m_viewSize)
             throwError("read failed");
 
-        v = stdext::readSLE32((const uint8_t*)&m_strData[m_pos]);
+        v = stdext::readSLE32(&m_viewData[m_pos]);
         m_pos += 4;
     } else {
         if (m_pos + 4 > m_data.size())
@@ -370,10 +422,10 @@ int64 FileStream::get64()
     if(!m_caching) {
         if(PHYSFS_readSLE64(m_fileHandle, (PHYSFS_sint64*)&v) == 0)
             throwError("read failed", true);
-    } else if(!m_strData.empty()) {
-        if (m_pos + 8 > m_strData.size())
+    } else if(m_viewData) {
+        if (m_pos + 8 > m_viewSize)
             throwError("read failed");
-        v = stdext::readSLE64((const uint8_t*)&m_strData[m_pos]);
+        v = stdext::readSLE64(&m_viewData[m_pos]);
         m_pos += 8;
     } else {
         if (m_pos + 8 > m_data.size())
@@ -395,13 +447,13 @@ std::string FileStream::getString()
                 throwError("read failed", true);
             else
                 str = std::string(buffer.begin(), buffer.end());
-        } else if(!m_strData.empty()) {
-            if (m_pos + len > m_strData.size()) {
+        } else if(m_viewData) {
+            if (m_pos + len > m_viewSize) {
                 throwError("read failed");
                 return 0;
             }
 
-            str = std::string((char*)&m_strData[m_pos], len);
+            str = std::string((char*)&m_viewData[m_pos], len);
             m_pos += len;
         } else {
             if (m_pos + len > m_data.size()) {
@@ -36,18 +36,24 @@ class FileStream : public LuaObject
 public:
     FileStream(const std::string& name, PHYSFS_File *fileHandle, bool writeable);
     FileStream(const std::string& name, std::string&& buffer);
+    // reads from memory owned by dataOwner, e.g. a mapped file
+    FileStream(const std::string& name, const uint8* data, uint size, const std::shared_ptr<void>& dataOwner);
     ~FileStream();
 
     void close();
     void flush();
     void write(const void *buffer, uint count);
     int read(void *buffer, uint size, uint nmemb = 1);
+    int readAt(uint pos, void *buffer, uint size); // @dontbind
     void seek(uint pos);
     void skip(uint len);
     uint size();
     uint tell();
     bool eof();
     std::string name() { return m_name; }
+    // another stream over the data of a cached stream, with its own position; nullptr for uncached streams.
+    // unless the data is mapped, this stream must outlive the view
+    FileStreamPtr createView();
 
     uint8 getU8();
     uint16 getU16();
@@ -89,6 +95,11 @@ private:
 
     DataBuffer<uint8_t> m_data;
     std::string m_strData;
+    // read only data of cached streams, points into m_strData or into memory kept alive by m_viewOwner
+    const uint8* m_viewData = nullptr;
+    uint m_viewSize = 0;
+    std::shared_ptr<void> m_viewOwner;
+    std::mutex m_readMutex;
 };
 
 #endif
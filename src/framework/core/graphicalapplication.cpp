@@ -26,6 +26,7 @@
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/asyncdispatcher.h>
+#include <framework/core/resourcemanager.h>
 #include <framework/platform/platformwindow.h>
 #include <framework/ui/uimanager.h>
 #include <framework/graphics/graph.h>
@@ -140,15 +141,49 @@ void GraphicalApplication::run()
 
     ticks_t lastRender = stdext::micros();
 
+    // the worker builds the next frame while the newest finished one waits here and the render thread
+    // draws the previous one, both sides are woken by condition variables instead of polling
     std::shared_ptr<DrawQueue> drawQueue;
     std::shared_ptr<DrawQueue> drawMapQueue;
     std::shared_ptr<DrawQueue> drawMapForegroundQueue;
+    std::mutex mutex;
+    std::condition_variable frameProduced, frameConsumed;
     bool isOnline = false;
     size_t totalFrames = 0;
 
-    std::mutex mutex;
+    // the map background is the most expensive pass and touches nothing the ui passes write, so it can be
+    // built on a second thread while the dispatcher builds the ui, the game state doesn't change meanwhile
+    // because events are only polled between frames. Both passes walk the widget tree, which only the
+    // dispatcher changes and not while rendering. During MapBackgroundPane every drawSelf except UIMap's
+    // must return before touching anything, the map may only share ThingType textures and animators with
+    // the ui, both are locked per instance
+    std::mutex mapMutex;
+    std::condition_variable mapCondition;
+    bool mapRequested = false;
+    std::shared_ptr<DrawQueue> mapBackgroundResult;
+    std::thread mapWorker([&] {
+        std::unique_lock<std::mutex> lock(mapMutex);
+        while (true) {
+            mapCondition.wait(lock, [&] { return mapRequested || m_stopping; });
+            if (!mapRequested)
+                break;
+            lock.unlock();
+            {
+                AutoStat s(STATS_MAIN, "DrawMapBackground");
+                g_drawQueue = std::make_shared<DrawQueue>();
+                g_ui.render(Fw::MapBackgroundPane);
+            }
+            lock.lock();
+            mapBackgroundResult = g_drawQueue;
+            g_drawQueue = nullptr;
+            mapRequested = false;
+            mapCondition.notify_all();
+        }
+    });
+
     std::thread worker([&] {
         g_dispatcherThreadId = std::this_thread::get_id();
+        ticks_t lastForeground = 0;
         while (!m_stopping) {
             m_processingFrames.addFrame();
             {
@@ -157,50 +192,98 @@ void GraphicalApplication::run()
                 g_clock.update();
             }
 
-            mutex.lock();
-            if (drawQueue && drawMapQueue && m_maxFps > 0) { // old drawQueue not processed yet
-                mutex.unlock();
-                AutoStat s(STATS_MAIN, "Sleep");
-                stdext::millisleep(1);
-                continue;
+            {
+                // with a frame limit or vsync don't build frames the render thread would drop, wait until it takes
+                // the pending one, the timeout keeps events polled while the render thread is stalled
+                std::unique_lock<std::mutex> lock(mutex);
+                if (drawMapQueue && (m_maxFps > 0 || g_window.hasVerticalSync())) {
+                    AutoStat s(STATS_MAIN, "Sleep");
+                    frameConsumed.wait_for(lock, std::chrono::milliseconds(1), [&] { return !drawMapQueue || m_stopping; });
+                    continue;
+                }
             }
-            mutex.unlock();
 
             ticks_t renderStart = stdext::millis();
-            {
-                AutoStat s(STATS_MAIN, "DrawMapBackground");
-                g_drawQueue = std::make_shared<DrawQueue>();
-                g_ui.render(Fw::MapBackgroundPane);
-            }
-            std::shared_ptr<DrawQueue> mapBackgroundQueue = g_drawQueue;
-            {
-                AutoStat s(STATS_MAIN, "DrawMapForeground");
-                g_drawQueue = std::make_shared<DrawQueue>();
-                g_ui.render(Fw::MapForegroundPane);
-            }
+            // when the adaptive renderer asks for it the ui is rebuilt less often, the render thread keeps drawing
+            // the last ui frame meanwhile, a repaint always rebuilds it
+            int foregroundInterval = g_adaptiveRenderer.foregroundUpdateInterval();
+            bool drawForeground = foregroundInterval == 0 || m_mustRepaint || renderStart >= lastForeground + foregroundInterval;
+            if (drawForeground)
+                lastForeground = renderStart;
+            if (m_parallelMapPass && m_mapPassThreadSafe) {
+                {
+                    std::lock_guard<std::mutex> lock(mapMutex);
+                    mapRequested = true;
+                }
+                mapCondition.notify_all();
+
+                std::shared_ptr<DrawQueue> foregroundQueue;
+                if (drawForeground) {
+                    AutoStat s(STATS_MAIN, "DrawForeground");
+                    ticks_t start = stdext::micros();
+                    g_drawQueue = std::make_shared<DrawQueue>();
+                    g_ui.render(Fw::ForegroundPane);
+                    foregroundQueue = g_drawQueue;
+                    g_adaptiveRenderer.addPhaseTime(AdaptiveRenderer::PhaseUI, stdext::micros() - start);
+                }
 
-            mutex.lock();
-            drawMapQueue = mapBackgroundQueue;
-            drawMapForegroundQueue = g_drawQueue;
-            mutex.unlock();
+                std::shared_ptr<DrawQueue> mapBackgroundQueue;
+                {
+                    AutoStat s(STATS_MAIN, "WaitMapBackground");
+                    std::unique_lock<std::mutex> lock(mapMutex);
+                    mapCondition.wait(lock, [&] { return !mapRequested; });
+                    mapBackgroundQueue = std::move(mapBackgroundResult);
+                }
 
-            {
-                AutoStat s(STATS_MAIN, "DrawForeground");
-                g_drawQueue = std::make_shared<DrawQueue>();
-                g_ui.render(Fw::ForegroundPane);
-            }
+                // the map foreground uses what the background pass computed, so it follows it
+                {
+                    AutoStat s(STATS_MAIN, "DrawMapForeground");
+                    g_drawQueue = std::make_shared<DrawQueue>();
+                    g_ui.render(Fw::MapForegroundPane);
+                }
 
-            mutex.lock();
-            drawQueue = g_drawQueue;
-            g_drawQueue = nullptr;
-            mutex.unlock();
+                mutex.lock();
+                drawMapQueue = mapBackgroundQueue;
+                drawMapForegroundQueue = g_drawQueue;
+                if (foregroundQueue)
+                    drawQueue = foregroundQueue;
+                g_drawQueue = nullptr;
+                mutex.unlock();
+                frameProduced.notify_one();
+            } else {
+                {
+                    AutoStat s(STATS_MAIN, "DrawMapBackground");
+                    g_drawQueue = std::make_shared<DrawQueue>();
+                    g_ui.render(Fw::MapBackgroundPane);
+                }
+                std::shared_ptr<DrawQueue> mapBackgroundQueue = g_drawQueue;
+                {
+                    AutoStat s(STATS_MAIN, "DrawMapForeground");
+                    g_drawQueue = std::make_shared<DrawQueue>();
+                    g_ui.render(Fw::MapForegroundPane);
+                }
 
-            g_graphs[GRAPH_CPU_FRAME_TIME].addValue(stdext::millis() - renderStart);
+                mutex.lock();
+                drawMapQueue = mapBackgroundQueue;
+                drawMapForegroundQueue = g_drawQueue;
+                mutex.unlock();
 
-            if (m_maxFps > 0 || g_window.hasVerticalSync()) {
-                AutoStat s(STATS_MAIN, "Sleep");
-                stdext::millisleep(1);
+                if (drawForeground) {
+                    AutoStat s(STATS_MAIN, "DrawForeground");
+                    ticks_t start = stdext::micros();
+                    g_drawQueue = std::make_shared<DrawQueue>();
+                    g_ui.render(Fw::ForegroundPane);
+                    g_adaptiveRenderer.addPhaseTime(AdaptiveRenderer::PhaseUI, stdext::micros() - start);
+
+                    mutex.lock();
+                    drawQueue = g_drawQueue;
+                    mutex.unlock();
+                }
+                g_drawQueue = nullptr;
+                frameProduced.notify_one();
             }
+
+            g_graphs[GRAPH_CPU_FRAME_TIME].addValue(stdext::millis() - renderStart);
         }
         g_dispatcher.poll(); // last poll
         g_dispatcherThreadId = g_mainThreadId;
@@ -225,26 +308,35 @@ void GraphicalApplication::run()
         m_maxFps = 150;
 #endif
         int frameDelay = m_maxFps <= 0 ? 0 : (1000000 / m_maxFps);
-        if (lastRender + frameDelay > stdext::micros() && !m_mustRepaint) {
+        ticks_t frameDeadline = lastRender + frameDelay;
+        if (frameDeadline > stdext::micros() && !m_mustRepaint) {
+            // sleep right up to the deadline instead of in 1 ms steps, at most 10 ms to keep the window polled
             AutoStat s(STATS_RENDER, "Sleep");
-            stdext::millisleep(1);
+            ticks_t remaining = std::min<ticks_t>(frameDeadline - stdext::micros(), 10000);
+            if (remaining > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(remaining));
             continue;
         }
 
-        mutex.lock();
-        if ((!drawQueue && !toDrawQueue) || 
-            ((!drawMapQueue || !drawMapForegroundQueue) && isOnline) || 
-            (m_mustRepaint && !drawQueue)) {
-            mutex.unlock();
-            AutoStat s(STATS_RENDER, "Wait");
-            stdext::millisleep(1);
-            continue;
+        {
+            auto frameReady = [&] {
+                return (drawQueue || toDrawQueue) &&
+                    ((drawMapQueue && drawMapForegroundQueue) || !isOnline) &&
+                    (!m_mustRepaint || drawQueue);
+            };
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!frameReady()) {
+                AutoStat s(STATS_RENDER, "Wait");
+                frameProduced.wait_for(lock, std::chrono::milliseconds(1), frameReady);
+                if (!frameReady())
+                    continue;
+            }
+            toDrawQueue = drawQueue ? drawQueue : toDrawQueue;
+            toDrawMapQueue = drawMapQueue;
+            toDrawMapForegroundQueue = drawMapForegroundQueue;
+            drawQueue = drawMapQueue = drawMapForegroundQueue = nullptr;
         }
-        toDrawQueue = drawQueue ? drawQueue : toDrawQueue;
-        toDrawMapQueue = drawMapQueue;
-        toDrawMapForegroundQueue = drawMapForegroundQueue;
-        drawQueue = drawMapQueue = drawMapForegroundQueue = nullptr;
-        mutex.unlock();
+        frameConsumed.notify_one();
 
         g_adaptiveRenderer.newFrame();
         m_graphicsFrames.addFrame();
@@ -252,6 +344,11 @@ void GraphicalApplication::run()
         lastRender = stdext::micros() > lastRender + frameDelay * 2 ? stdext::micros() : lastRender + frameDelay;
 
         g_painter->resetDraws();
+        ticks_t frameStart = stdext::micros();
+        bool benchmarkFrame = m_benchmark;
+        if (benchmarkFrame)
+            beginBenchmarkFrame();
+
         if (m_scaling > 1.0f) {
             AutoStat s(STATS_RENDER, "SetupScaling");
             g_painter->setResolution(g_graphics.getViewportSize() / m_scaling);
@@ -261,11 +358,16 @@ void GraphicalApplication::run()
 
         if (toDrawMapQueue && toDrawMapQueue->hasFrameBuffer()) {
             AutoStat s(STATS_RENDER, "UpdateMap");
-            m_mapFramebuffer->resize(toDrawMapQueue->getFrameBufferSize());
-            m_mapFramebuffer->bind();
-            g_painter->clear(Color::black);
-            toDrawMapQueue->draw(DRAW_ALL);
-            m_mapFramebuffer->release();
+            if (m_mapFrameBufferReuse) {
+                m_mapFramebuffer = m_mapFrameBufferCache.draw(*toDrawMapQueue, m_mapFramebuffer->isSmooth());
+            } else {
+                m_mapFrameBufferCache.reset();
+                m_mapFramebuffer->resize(toDrawMapQueue->getFrameBufferSize());
+                m_mapFramebuffer->bind();
+                g_painter->clear(Color::black);
+                toDrawMapQueue->draw(DRAW_ALL);
+                m_mapFramebuffer->release();
+            }
         }
 
         {
@@ -336,6 +438,8 @@ void GraphicalApplication::run()
 
         AutoStat s(STATS_RENDER, "SwapBuffers");
         g_window.swapBuffers();
+        if (benchmarkFrame)
+            endBenchmarkFrame(frameStart);
         g_graphics.checkForError(__FUNCTION__, __FILE__, __LINE__);
         g_graphs[GRAPH_TOTAL_FRAME_TIME].addValue(stdext::millis() - lastFrame);
         lastFrame = stdext::millis();
@@ -361,15 +465,125 @@ void GraphicalApplication::run()
     }
 
     worker.join();
+    {
+        std::lock_guard<std::mutex> lock(mapMutex);
+        mapCondition.notify_all();
+    }
+    mapWorker.join();
     g_graphicsDispatcher.poll();
 
     m_framebuffer = nullptr;
     m_mapFramebuffer = nullptr;
+    m_mapFrameBufferCache.reset();
+#ifndef OPENGL_ES
+    if (m_gpuTimerQueries[0]) {
+        glDeleteQueries(2, m_gpuTimerQueries);
+        m_gpuTimerQueries[0] = m_gpuTimerQueries[1] = 0;
+    }
+#endif
     g_drawQueue = nullptr;
     m_stopping = false;
     m_running = false;
 }
 
+void GraphicalApplication::startBenchmark()
+{
+    std::lock_guard<std::mutex> lock(m_benchmarkMutex);
+    m_benchmarkFrames.clear();
+    m_gpuTimerFrame = -1;
+    m_benchmarkStart = stdext::micros();
+    m_benchmark = true;
+}
+
+std::map<std::string, double> GraphicalApplication::stopBenchmark(const std::string& csvFile)
+{
+    std::vector<BenchmarkFrame> frames;
+    ticks_t duration;
+    {
+        std::lock_guard<std::mutex> lock(m_benchmarkMutex);
+        m_benchmark = false;
+        frames.swap(m_benchmarkFrames);
+        m_gpuTimerFrame = -1;
+        duration = stdext::micros() - m_benchmarkStart;
+    }
+
+    std::map<std::string, double> result;
+    result["frames"] = frames.size();
+    result["duration"] = duration / 1000.0;
+    if (frames.empty())
+        return result;
+
+    std::vector<int> cpu, gpu;
+    double calls = 0, draws = 0;
+    std::stringstream csv;
+    csv << "frame,cpu_us,gpu_us,calls,vertices\n";
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const BenchmarkFrame& frame = frames[i];
+        cpu.push_back(frame.cpu);
+        if (frame.gpu >= 0)
+            gpu.push_back(frame.gpu);
+        calls += frame.calls;
+        draws += frame.draws;
+        csv << i << "," << frame.cpu << "," << frame.gpu << "," << frame.calls << "," << frame.draws << "\n";
+    }
+
+    // times are reported in milliseconds
+    auto addTimes = [&](const std::string& name, std::vector<int>& times) {
+        if (times.empty()) {
+            result[name + "Avg"] = -1;
+            return;
+        }
+        std::sort(times.begin(), times.end());
+        double sum = 0;
+        for (int time : times)
+            sum += time;
+        result[name + "Avg"] = sum / times.size() / 1000.0;
+        result[name + "P50"] = times[times.size() / 2] / 1000.0;
+        result[name + "P95"] = times[std::min<size_t>(times.size() - 1, times.size() * 95 / 100)] / 1000.0;
+        result[name + "Max"] = times.back() / 1000.0;
+    };
+    addTimes("cpu", cpu);
+    addTimes("gpu", gpu);
+    result["fps"] = frames.size() * 1000000.0 / std::max<ticks_t>(duration, 1);
+    result["callsAvg"] = calls / frames.size();
+    result["verticesAvg"] = draws / frames.size();
+
+    if (!csvFile.empty() && !g_resources.writeFileContents(csvFile, csv.str()))
+        g_logger.error(stdext::format("Unable to save benchmark frames to %s", csvFile));
+    return result;
+}
+
+void GraphicalApplication::beginBenchmarkFrame()
+{
+#ifndef OPENGL_ES
+    if (!GLEW_ARB_timer_query)
+        return;
+    if (!m_gpuTimerQueries[0])
+        glGenQueries(2, m_gpuTimerQueries);
+    m_gpuTimerSlot ^= 1;
+    glBeginQuery(GL_TIME_ELAPSED, m_gpuTimerQueries[m_gpuTimerSlot]);
+#endif
+}
+
+void GraphicalApplication::endBenchmarkFrame(ticks_t frameStart)
+{
+    BenchmarkFrame frame = { (int)(stdext::micros() - frameStart), -1, g_painter->calls(), g_painter->draws() };
+    std::lock_guard<std::mutex> lock(m_benchmarkMutex);
+#ifndef OPENGL_ES
+    if (GLEW_ARB_timer_query) {
+        glEndQuery(GL_TIME_ELAPSED);
+        // the previous frame is finished by now, waiting for the current one would stall the pipeline
+        if (m_gpuTimerFrame >= 0 && m_gpuTimerFrame < (int)m_benchmarkFrames.size()) {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(m_gpuTimerQueries[m_gpuTimerSlot ^ 1], GL_QUERY_RESULT, &elapsed);
+            m_benchmarkFrames[m_gpuTimerFrame].gpu = (int)(elapsed / 1000);
+        }
+        m_gpuTimerFrame = m_benchmarkFrames.size();
+    }
+#endif
+    m_benchmarkFrames.push_back(frame);
+}
+
 void GraphicalApplication::poll() {
     ticks_t start = stdext::millis();
 #ifdef FW_SOUND
@@ -496,6 +710,12 @@ void GraphicalApplication::scale(float value)
 
 void GraphicalApplication::setSmooth(bool value)
 {
+    // the map framebuffer is swapped by the render thread when it's reused
+    if (g_mainThreadId != std::this_thread::get_id()) {
+        g_graphicsDispatcher.addEvent(std::bind(&GraphicalApplication::setSmooth, this, value));
+        return;
+    }
+
     if (!m_mapFramebuffer) return;
 
     m_mapFramebuffer->setSmooth(value);
@@ -503,6 +723,11 @@ void GraphicalApplication::setSmooth(bool value)
 
 void GraphicalApplication::doMapScreenshot(std::string fileName)
 {
+    if (g_mainThreadId != std::this_thread::get_id()) {
+        g_graphicsDispatcher.addEvent(std::bind(&GraphicalApplication::doMapScreenshot, this, fileName));
+        return;
+    }
+
     if (!m_mapFramebuffer) return;
 
     m_mapFramebuffer->doScreenshot(fileName);
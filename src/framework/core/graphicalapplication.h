@@ -26,7 +26,9 @@
 
 #include "application.h"
 #include <atomic>
+#include <mutex>
 #include <framework/graphics/declarations.h>
+#include <framework/graphics/drawqueue.h>
 #include <framework/core/inputevent.h>
 #include <framework/core/adaptiverenderer.h>
 #include <framework/util/framecounter.h>
@@ -53,6 +55,21 @@ public:
 
     bool isOnInputEvent() { return m_onInputEvent; }
 
+    // builds the map background on its own thread while the ui is built, off by default,
+    // see the map worker in GraphicalApplication::run for what may run concurrently
+    void setParallelMapPass(bool enable) { m_parallelMapPass = enable; }
+    bool isParallelMapPass() { return m_parallelMapPass; }
+    void setMapPassThreadSafe(bool safe) { m_mapPassThreadSafe = safe; }
+
+    // keeps the map framebuffer between frames and redraws only what changed, lights are drawn over a copy of it
+    void setMapFrameBufferReuse(bool enable) { m_mapFrameBufferReuse = enable; }
+    bool isMapFrameBufferReuse() { return m_mapFrameBufferReuse; }
+
+    // collects cpu and gpu time, draw calls and vertices of every rendered frame until stopped,
+    // returns a summary and optionally saves all frames as csv
+    void startBenchmark();
+    std::map<std::string, double> stopBenchmark(const std::string& csvFile);
+
     int getIteration() {
         return m_iteration;
     }
@@ -70,16 +87,38 @@ protected:
     void inputEvent(InputEvent event);
 
 private:
+    struct BenchmarkFrame {
+        int cpu; // microseconds
+        int gpu; // microseconds, -1 if gpu timer queries aren't supported
+        int calls;
+        int draws;
+    };
+
+    void beginBenchmarkFrame();
+    void endBenchmarkFrame(ticks_t frameStart);
+
     int m_iteration = 0;
     std::atomic<float> m_scaling = 1.0;
     std::atomic<float> m_lastScaling = 1.0;
     std::atomic_int m_maxFps = 100;
     stdext::boolean<false> m_onInputEvent;
     stdext::boolean<false> m_mustRepaint;
+    std::atomic_bool m_parallelMapPass = false;
+    std::atomic_bool m_mapPassThreadSafe = true;
+    std::atomic_bool m_mapFrameBufferReuse = false;
     FrameBufferPtr m_framebuffer, m_mapFramebuffer;
+    DrawQueueFrameBufferCache m_mapFrameBufferCache;
     FrameCounter m_graphicsFrames;
     FrameCounter m_processingFrames;
     stdext::timer m_windowPollTimer;
+
+    std::atomic_bool m_benchmark = false;
+    std::mutex m_benchmarkMutex;
+    std::vector<BenchmarkFrame> m_benchmarkFrames;
+    ticks_t m_benchmarkStart = 0;
+    uint m_gpuTimerQueries[2] = { 0, 0 };
+    int m_gpuTimerSlot = 0;
+    int m_gpuTimerFrame = -1; // frame measured by the query in the other slot
 };
 
 extern GraphicalApplication g_app;
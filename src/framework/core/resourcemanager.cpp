@@ -25,6 +25,7 @@
 #include "resource.h"
 
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/luaengine/luainterface.h>
 #include <framework/platform/platform.h>
 #include <framework/util/crypt.h>
@@ -43,6 +44,8 @@
 #ifndef __EMSCRIPTEN__
 #include <zip.h>
 #include <zlib.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #endif
 
 ResourceManager g_resources;
@@ -356,6 +359,21 @@ bool ResourceManager::fileExists(const std::string& fileName)
     return (PHYSFS_exists(resolvePath(fileName).c_str()) && !PHYSFS_isDirectory(resolvePath(fileName).c_str()));
 }
 
+bool ResourceManager::getFileStat(const std::string& fileName, int64& size, int64& modTime)
+{
+    std::string fullPath = resolvePath(fileName);
+    if (fullPath.find("/downloads") != std::string::npos)
+        return false;
+
+    PHYSFS_Stat stat;
+    if (!PHYSFS_stat(fullPath.c_str(), &stat) || stat.filetype != PHYSFS_FILETYPE_REGULAR)
+        return false;
+
+    size = stat.filesize;
+    modTime = stat.modtime;
+    return true;
+}
+
 bool ResourceManager::directoryExists(const std::string& directoryName)
 {
     if (directoryName == "/downloads")
@@ -433,7 +451,7 @@ bool ResourceManager::isFileEncryptedOrCompressed(const std::string& fileName)
         }
     }
 
-    if (!fileContent.empty()) {
+    if (fileContent.empty()) {
         PHYSFS_File* file = PHYSFS_openRead(fullPath.c_str());
         if (!file)
             stdext::throw_exception(stdext::format("unable to open file '%s': %s", fullPath, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
@@ -491,6 +509,10 @@ bool ResourceManager::writeFileContents(const std::string& fileName, const std::
 FileStreamPtr ResourceManager::openFile(const std::string& fileName, bool dontCache)
 {
     std::string fullPath = resolvePath(fileName);
+    if (!dontCache) {
+        if (FileStreamPtr mappedFile = mapFile(fullPath))
+            return mappedFile;
+    }
     if (isFileEncryptedOrCompressed(fullPath) || !dontCache) {
         return FileStreamPtr(new FileStream(fullPath, readFileContents(fullPath)));
     }
@@ -500,6 +522,40 @@ FileStreamPtr ResourceManager::openFile(const std::string& fileName, bool dontCa
     return FileStreamPtr(new FileStream(fullPath, file, false));
 }
 
+FileStreamPtr ResourceManager::mapFile(const std::string& fullPath)
+{
+#ifndef __EMSCRIPTEN__
+    // only plain files in a mounted directory can be mapped, files inside archives or downloads can't
+    if (m_customEncryption != 0 || fullPath.empty() || fullPath[0] != '/' || fullPath.find("/downloads") != std::string::npos)
+        return nullptr;
+
+    const char* realDir = PHYSFS_getRealDir(fullPath.c_str());
+    if (!realDir)
+        return nullptr;
+
+    try {
+        std::error_code ec;
+        std::filesystem::path realPath = std::filesystem::u8path(realDir) / std::filesystem::u8path(fullPath.substr(1));
+        if (!std::filesystem::is_regular_file(realPath, ec) || std::filesystem::file_size(realPath, ec) < 10)
+            return nullptr;
+
+        boost::interprocess::file_mapping mapping(realPath.string().c_str(), boost::interprocess::read_only);
+        auto region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+        const uint8* data = (const uint8*)region->get_address();
+
+        // encrypted and compressed files are still unpacked in memory by readFileContents
+        if (memcmp(data, "ENC3", 4) == 0 || (data[0] == 0x1f && data[1] == 0x8b && data[2] == 0x08))
+            return nullptr;
+
+        return FileStreamPtr(new FileStream(fullPath, data, region->get_size(), region));
+    } catch (std::exception&) {
+        return nullptr;
+    }
+#else
+    return nullptr;
+#endif
+}
+
 FileStreamPtr ResourceManager::appendFile(const std::string& fileName)
 {
     PHYSFS_File* file = PHYSFS_openAppend(fileName.c_str());
@@ -589,27 +645,153 @@ bool ResourceManager::isFileType(const std::string& filename, const std::string&
 }
 
 std::string ResourceManager::fileChecksum(const std::string& path) {
-    static std::map<std::string, std::string> cache;
+    return fileChecksums({ path })[path];
+}
+
+std::map<std::string, std::string> ResourceManager::fileChecksums(const std::vector<std::string>& paths, const std::function<void(int, int)>& onProgress)
+{
+    struct ChecksumBatch {
+        std::vector<std::string> paths;
+        std::vector<std::string> checksums;
+        std::atomic<size_t> next;
+        size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable progress;
+    };
+
+    std::map<std::string, std::string> ret;
+    if (paths.empty())
+        return ret;
+
+    loadChecksumsCache();
+
+    auto batch = std::make_shared<ChecksumBatch>();
+    batch->paths = paths;
+    batch->checksums.resize(paths.size());
+    batch->next = 0;
+
+    // workers pull paths until none are left, the calling thread works too
+    auto work = [this, batch] {
+        size_t i;
+        while ((i = batch->next++) < batch->paths.size()) {
+            std::string checksum = computeChecksum(batch->paths[i]);
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->checksums[i] = checksum;
+            batch->done++;
+            batch->progress.notify_all();
+        }
+    };
+
+    size_t workers = std::min<size_t>(3, paths.size() - 1);
+    for (size_t i = 0; i < workers; ++i)
+        g_asyncDispatcher.dispatch(work);
+    work();
+
+    size_t reported = 0;
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    while (true) {
+        size_t done = batch->done;
+        if (onProgress && done != reported) {
+            reported = done;
+            lock.unlock();
+            onProgress(done, paths.size());
+            lock.lock();
+            continue;
+        }
+        if (done == paths.size())
+            break;
+        batch->progress.wait(lock);
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i)
+        ret[paths[i]] = batch->checksums[i];
+    lock.unlock();
+
+    saveChecksumsCache();
+    return ret;
+}
 
-    auto it = cache.find(path);
-    if (it != cache.end())
-        return it->second;
+std::string ResourceManager::computeChecksum(const std::string& path)
+{
+    PHYSFS_Stat stat;
+    bool hasStat = PHYSFS_stat(path.c_str(), &stat) && stat.filetype == PHYSFS_FILETYPE_REGULAR;
+    if (hasStat) {
+        std::lock_guard<std::mutex> lock(m_checksumsMutex);
+        auto it = m_checksums.find(path);
+        if (it != m_checksums.end() && it->second.size == stat.filesize && it->second.modTime == stat.modtime)
+            return it->second.checksum;
+    }
 
     PHYSFS_File* file = PHYSFS_openRead(path.c_str());
     if(!file)
         return "";
 
-    int fileSize = PHYSFS_fileLength(file);
-    std::string buffer(fileSize, 0);
-    PHYSFS_readBytes(file, (void*)&buffer[0], fileSize);
+    // hash in chunks, the whole file is never held in memory
+    uLong crc = ::crc32(0, Z_NULL, 0);
+    std::vector<uint8_t> buffer(1024 * 1024);
+    PHYSFS_sint64 read;
+    while ((read = PHYSFS_readBytes(file, buffer.data(), buffer.size())) > 0)
+        crc = ::crc32(crc, buffer.data(), (uInt)read);
     PHYSFS_close(file);
 
-    auto checksum = g_crypt.crc32(buffer, false);
-    cache[path] = checksum;
+    // uLong is 64-bit on most unix systems, the checksum is always 8 digits
+    std::string checksum = stdext::dec_to_hex((uint32_t)crc);
+    std::transform(checksum.begin(), checksum.end(), checksum.begin(), tolower);
 
+    if (hasStat) {
+        std::lock_guard<std::mutex> lock(m_checksumsMutex);
+        m_checksums[path] = { stat.filesize, stat.modtime, checksum };
+        m_checksumsChanged = true;
+    }
     return checksum;
 }
 
+void ResourceManager::loadChecksumsCache()
+{
+    std::lock_guard<std::mutex> lock(m_checksumsMutex);
+    if (m_checksumsLoaded)
+        return;
+    m_checksumsLoaded = true;
+
+    PHYSFS_File* file = PHYSFS_openRead("checksums.cache");
+    if (!file)
+        return;
+    std::string buffer(PHYSFS_fileLength(file), 0);
+    if (!buffer.empty())
+        PHYSFS_readBytes(file, (void*)&buffer[0], buffer.size());
+    PHYSFS_close(file);
+
+    // one file per line: checksum size modtime path
+    std::istringstream in(buffer);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream lineStream(line);
+        FileChecksum entry;
+        std::string path;
+        if (!(lineStream >> entry.checksum >> entry.size >> entry.modTime) || entry.checksum.size() != 8)
+            continue;
+        lineStream.get();
+        std::getline(lineStream, path);
+        if (!path.empty())
+            m_checksums[path] = entry;
+    }
+}
+
+void ResourceManager::saveChecksumsCache()
+{
+    std::string data;
+    {
+        std::lock_guard<std::mutex> lock(m_checksumsMutex);
+        if (!m_checksumsChanged)
+            return;
+        m_checksumsChanged = false;
+
+        for (auto& it : m_checksums)
+            data += it.second.checksum + " " + std::to_string(it.second.size) + " " + std::to_string(it.second.modTime) + " " + it.first + "\n";
+    }
+    writeFileContents("checksums.cache", data);
+}
+
 std::map<std::string, std::string> ResourceManager::filesChecksums()
 {
     std::map<std::string, std::string> ret;
@@ -1064,7 +1246,7 @@ bool ResourceManager::decryptBuffer(std::string& buffer) {
         }
     }
 
-    buffer = new_buffer;
+    buffer = std::move(new_buffer);
     return true;
 #endif
 }
@@ -1098,7 +1280,7 @@ bool ResourceManager::encryptBuffer(std::string& buffer, uint32_t seed) {
     *(uint32_t*)&new_buffer[20] = ((uint32_t)stdext::adler32((const uint8_t*)&buffer[0], buffer.size())) ^ seed;
 
     g_crypt.bencrypt((uint8_t*)&new_buffer[0] + 24, new_buffer.size() - 24, key);
-    buffer = new_buffer;
+    buffer = std::move(new_buffer);
     return true;
 }
 #endif
@@ -43,6 +43,8 @@ public:
 
     bool fileExists(const std::string& fileName);
     bool directoryExists(const std::string& directoryName);
+    // @dontbind
+    bool getFileStat(const std::string& fileName, int64& size, int64& modTime);
 
     // @dontbind
     void readFileStream(const std::string& fileName, std::iostream& out);
@@ -80,7 +82,8 @@ public:
     bool isLoadedFromMemory() { return m_loadedFromMemory; }
 
     std::string fileChecksum(const std::string& path);
-    
+    std::map<std::string, std::string> fileChecksums(const std::vector<std::string>& paths, const std::function<void(int, int)>& onProgress = nullptr);
+
     std::map<std::string, std::string> filesChecksums();
     std::string selfChecksum();
 
@@ -111,6 +114,10 @@ public:
 private:
     bool mountMemoryData(const std::shared_ptr<std::vector<uint8_t>>& data);
     void unmountMemoryData();
+    std::string computeChecksum(const std::string& path);
+    void loadChecksumsCache();
+    void saveChecksumsCache();
+    FileStreamPtr mapFile(const std::string& fullPath);
 
 #ifndef ANDROID
     std::filesystem::path m_binaryPath, m_writeDir;
@@ -119,6 +126,17 @@ private:
     bool m_loadedFromArchive = false;
     std::shared_ptr<std::vector<uint8_t>> m_memoryData;
     uint32_t m_customEncryption = 0;
+
+    // crc32 of files by path, reused while size and modification time don't change
+    struct FileChecksum {
+        int64 size;
+        int64 modTime;
+        std::string checksum;
+    };
+    std::unordered_map<std::string, FileChecksum> m_checksums;
+    std::mutex m_checksumsMutex;
+    bool m_checksumsLoaded = false;
+    bool m_checksumsChanged = false;
     std::string m_layout;
 };
 
@@ -22,20 +22,23 @@
 
 #include "animatedtexture.h"
 #include "graphics.h"
+#include "image.h"
 
+#include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
 
 AnimatedTexture::AnimatedTexture(const Size& size, std::vector<ImagePtr> frames, std::vector<int> framesDelay, bool buildMipmaps, bool compress) :
-    Texture(size)
+    Texture(size), m_frames(std::move(frames)), m_framesDelay(std::move(framesDelay))
 {
-    for(uint i=0;i<frames.size();++i) {
-        m_frames.push_back(new Texture(frames[i], buildMipmaps, compress));
-    }
+    // every frame keeps its own id, so cached draws of a frame stay valid when the animation loops
+    for(uint i = 0; i < m_frames.size(); ++i)
+        m_framesUniqueId.push_back(uniqueId++);
 
-    m_framesDelay = framesDelay;
     m_hasMipmaps = buildMipmaps;
-    m_uniqueId = 0;
+    m_uniqueId = m_framesUniqueId[0];
     m_currentFrame = 0;
+    m_uploadedFrame = -1;
+    m_lastDraw = g_clock.millis();
     m_animTimer.restart();
     setupTranformMatrix();
 }
@@ -47,26 +50,12 @@ AnimatedTexture::~AnimatedTexture()
 
 bool AnimatedTexture::buildHardwareMipmaps()
 {
-    for(const TexturePtr& frame : m_frames)
-        frame->buildHardwareMipmaps();
     m_hasMipmaps = true;
+    m_uploadedFrame = -1;
+    m_needsUpdate = true;
     return true;
 }
 
-void AnimatedTexture::setSmooth(bool smooth)
-{
-    for(const TexturePtr& frame : m_frames)
-        frame->setSmooth(smooth);
-    m_smooth = smooth;
-}
-
-void AnimatedTexture::setRepeat(bool repeat)
-{
-    for(const TexturePtr& frame : m_frames)
-        frame->setRepeat(repeat);
-    m_repeat = repeat;
-}
-
 void AnimatedTexture::update()
 {
     if (m_animTimer.ticksElapsed() >= m_framesDelay[m_currentFrame]) {
@@ -74,7 +63,27 @@ void AnimatedTexture::update()
         m_currentFrame = (m_currentFrame + 1) % m_frames.size();
     }
 
-    m_frames[m_currentFrame]->update();
-    m_id = m_frames[m_currentFrame]->getId();
-    m_uniqueId = m_frames[m_currentFrame]->getUniqueId();
+    m_lastDraw = g_clock.millis();
+    m_uniqueId = m_framesUniqueId[m_currentFrame];
+
+    Texture::update();
+    if (m_uploadedFrame == (int)m_currentFrame)
+        return;
+
+    const ImagePtr& frame = m_frames[m_currentFrame];
+    updatePixels(Rect(Point(0, 0), frame->getSize()), frame->getPixelData(), frame->getBpp());
+    if (m_hasMipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+    m_uploadedFrame = m_currentFrame;
+}
+
+void AnimatedTexture::releaseIfIdle(ticks_t idleTime)
+{
+    if (m_id == 0 || g_clock.millis() - m_lastDraw < idleTime)
+        return;
+
+    glDeleteTextures(1, &m_id);
+    m_id = 0;
+    m_uploadedFrame = -1;
+    m_needsUpdate = true;
 }
@@ -26,6 +26,8 @@
 #include "texture.h"
 #include <framework/core/timer.h>
 
+// Keeps the decoded frames in memory and uploads only the current one into a single texture,
+// so an animation costs one frame of video memory however long it is.
 class AnimatedTexture : public Texture
 {
 public:
@@ -35,18 +37,25 @@ public:
     void replace(const ImagePtr& image) { }
     void update();
 
+    // frees the video memory if the texture wasn't drawn for idleTime ms, render thread only
+    void releaseIfIdle(ticks_t idleTime);
+
+    ticks_t getLastDraw() { return m_lastDraw; }
+    bool hasGpuStorage() { return m_uploadedFrame >= 0; }
+    int getFramesCount() { return m_frames.size(); }
+
     virtual bool isAnimatedTexture() { return true; }
 
 protected:
     virtual bool buildHardwareMipmaps();
 
-    virtual void setSmooth(bool smooth);
-    virtual void setRepeat(bool repeat);
-
 private:
-    std::vector<TexturePtr> m_frames;
+    std::vector<ImagePtr> m_frames;
     std::vector<int> m_framesDelay;
+    std::vector<uint> m_framesUniqueId;
     uint m_currentFrame;
+    std::atomic<int> m_uploadedFrame;
+    std::atomic<ticks_t> m_lastDraw;
     Timer m_animTimer;
 };
 
@@ -37,6 +37,7 @@ class FrameBufferManager;
 class Shader;
 class ShaderProgram;
 class PainterShaderProgram;
+struct TextRenderCache;
 
 typedef stdext::shared_object_ptr<Image> ImagePtr;
 typedef stdext::shared_object_ptr<Texture> TexturePtr;
@@ -47,6 +48,7 @@ typedef stdext::shared_object_ptr<FrameBuffer> FrameBufferPtr;
 typedef stdext::shared_object_ptr<Shader> ShaderPtr;
 typedef stdext::shared_object_ptr<ShaderProgram> ShaderProgramPtr;
 typedef stdext::shared_object_ptr<PainterShaderProgram> PainterShaderProgramPtr;
+typedef std::shared_ptr<TextRenderCache> TextRenderCachePtr;
 typedef std::vector<ShaderPtr> ShaderList;
 
 #endif
@@ -6,7 +6,7 @@ void DrawCache::draw()
 {
     release();
     if (m_size == 0) return;
-    g_painter->drawCache(m_destCoord, m_srcCoord, m_color, m_size);
+    g_painter->drawCache(m_vertices, m_size);
     m_size = 0;
 }
 
@@ -27,39 +27,29 @@ void DrawCache::release()
 void DrawCache::addRect(const Rect& dest, const Color& color)
 {
     static Rect emptyRect(Point(-10, -10), Point(-10, -10));
-    addRectRaw(m_destCoord.data() + (m_size * 2), dest);
-    addRectRaw(m_srcCoord.data() + (m_size * 2), emptyRect);
-    addColorRaw(color, 6);
-    m_size += 6;
+    addQuad(dest, emptyRect, color);
 }
 
 void DrawCache::addTexturedRect(const Rect& dest, const Rect& src, const Color& color)
 {
-    addRectRaw(m_destCoord.data() + (m_size * 2), dest);
-    addRectRaw(m_srcCoord.data() + (m_size * 2), src);
-    addColorRaw(color, 6);
-    m_size += 6;
+    addQuad(dest, src, color);
 }
 
 void DrawCache::addCoords(CoordsBuffer& coords, const Color& color)
 {
+    float c[4] = { color.rF(), color.gF(), color.bF(), color.aF() };
     int size = coords.getVertexCount();
-    memcpy(m_destCoord.data() + m_size * 2, coords.getVertexArray(), size * 2 * sizeof(float));
-    for (int start = m_size * 2, end = (m_size + size) * 2; start < end; ++start)
-        m_srcCoord[start] = -10;
-    addColorRaw(color, size);
-    m_size += size;
+    float* dest = coords.getVertexArray();
+    for (int i = 0; i < size; ++i)
+        addVertex(dest[i * 2], dest[i * 2 + 1], -10, -10, c);
 }
 
 void DrawCache::addTexturedCoords(CoordsBuffer& coords, const Point& offset, const Color& color)
 {
+    float c[4] = { color.rF(), color.gF(), color.bF(), color.aF() };
     int size = coords.getVertexCount();
+    float* dest = coords.getVertexArray();
     float* src = coords.getTextureCoordArray();
-    memcpy(m_destCoord.data() + m_size * 2, coords.getVertexArray(), size * 2 * sizeof(float));
-    for (int i = m_size * 2, j = 0, end = (m_size + size) * 2; i < end; ) {
-        m_srcCoord[i++] = src[j++] + offset.x;
-        m_srcCoord[i++] = src[j++] + offset.y;
-    }
-    addColorRaw(color, size);
-    m_size += size;
+    for (int i = 0; i < size; ++i)
+        addVertex(dest[i * 2], dest[i * 2 + 1], src[i * 2] + offset.x, src[i * 2 + 1] + offset.y, c);
 }
@@ -24,28 +24,33 @@ public:
     void addTexturedCoords(CoordsBuffer& coords, const Point& offset, const Color& color);
 
 private:
-    inline void addRectRaw(float* dest, const Rect& rect)
+    // vertices are interleaved as x, y, u, v, r, g, b, a so a flush is a single buffer write
+    static const int VERTEX_SIZE = 8;
+
+    inline void addVertex(float x, float y, float u, float v, const float* color)
     {
-        dest[0] = dest[4] = dest[6] = rect.left();
-        dest[1] = dest[3] = dest[9] = rect.top();
-        dest[2] = dest[8] = dest[10] = rect.right() + 1;
-        dest[5] = dest[7] = dest[11] = rect.bottom() + 1;
+        float* dest = m_vertices.data() + m_size * VERTEX_SIZE;
+        dest[0] = x;
+        dest[1] = y;
+        dest[2] = u;
+        dest[3] = v;
+        memcpy(dest + 4, color, 4 * sizeof(float));
+        m_size += 1;
     }
-    inline void addColorRaw(const Color& color, int count)
+    inline void addQuad(const Rect& dest, const Rect& src, const Color& color)
     {
-        static float c[4];
-        c[0] = color.rF();
-        c[1] = color.gF();
-        c[2] = color.bF();
-        c[3] = color.aF();
-        for (int start = m_size * 4, end = (m_size + count) * 4; start < end; start += 4) {
-            memcpy(m_color.data() + start, c, 4 * sizeof(float));
-        }
+        float c[4] = { color.rF(), color.gF(), color.bF(), color.aF() };
+        float l = dest.left(), t = dest.top(), r = dest.right() + 1, b = dest.bottom() + 1;
+        float sl = src.left(), st = src.top(), sr = src.right() + 1, sb = src.bottom() + 1;
+        addVertex(l, t, sl, st, c);
+        addVertex(r, t, sr, st, c);
+        addVertex(l, b, sl, sb, c);
+        addVertex(l, b, sl, sb, c);
+        addVertex(r, t, sr, st, c);
+        addVertex(r, b, sr, sb, c);
     }
 
-    std::vector<float> m_destCoord = std::vector<float>(MAX_SIZE * 2);
-    std::vector<float> m_srcCoord = std::vector<float>(MAX_SIZE * 2);
-    std::vector<float> m_color = std::vector<float>(MAX_SIZE * 4);
+    std::vector<float> m_vertices = std::vector<float>(MAX_SIZE * VERTEX_SIZE);
     bool m_bound = false;
     int m_size = 0;
 };
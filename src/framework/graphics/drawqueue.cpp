@@ -11,7 +11,19 @@
 #include <client/spritemanager.h>
 #include <client/outfit.h>
 
-std::shared_ptr<DrawQueue> g_drawQueue;
+thread_local std::shared_ptr<DrawQueue> g_drawQueue;
+
+namespace {
+inline void hashCombine(uint64_t& seed, uint64_t value)
+{
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+inline uint64_t hashColor(const Color& color)
+{
+    return ((uint64_t)color.r() << 24) | ((uint64_t)color.g() << 16) | ((uint64_t)color.b() << 8) | color.a();
+}
+}
 
 void DrawQueueItemTextureCoords::draw()
 {
@@ -109,6 +121,19 @@ void DrawQueueItemTexturedRect::draw(const Point& pos)
     g_painter->drawTexturedRect(Rect(pos, m_texture->getSize()), m_texture);
 }
 
+bool DrawQueueItemTexturedRect::hash(uint64_t& hash, Rect& dest)
+{
+    if (!m_texture)
+        return false;
+    m_texture->update(); // animated textures pick their frame here
+    hash = m_texture->getUniqueId();
+    hashCombine(hash, ((uint64_t)m_src.x() << 32) | (uint32_t)m_src.y());
+    hashCombine(hash, ((uint64_t)m_src.width() << 32) | (uint32_t)m_src.height());
+    hashCombine(hash, hashColor(m_color));
+    dest = m_dest;
+    return true;
+}
+
 
 bool DrawQueueItemFilledRect::cache()
 {
@@ -117,6 +142,13 @@ bool DrawQueueItemFilledRect::cache()
     return true; 
 }
 
+bool DrawQueueItemFilledRect::hash(uint64_t& hash, Rect& dest)
+{
+    hash = hashColor(m_color);
+    dest = m_dest;
+    return true;
+}
+
 void DrawQueueItemClearRect::draw()
 {
     g_painter->clearRect(m_color, m_dest);
@@ -134,12 +166,18 @@ bool DrawQueueItemFillCoords::cache()
 
 void DrawQueueItemText::draw()
 {
-    g_text.drawText(m_point, m_hash, m_color, m_shadow);
+    g_text.drawText(m_point, m_text, m_color, m_shadow);
+}
+
+bool DrawQueueItemText::batch()
+{
+    g_text.batchText(m_point, m_text, m_color, m_shadow);
+    return true;
 }
 
 void DrawQueueItemTextColored::draw()
 {
-    g_text.drawColoredText(m_point, m_hash, m_colors, m_shadow);
+    g_text.drawColoredText(m_point, m_text, m_colors, m_shadow);
 }
 
 void::DrawQueueItemLine::draw()
@@ -215,15 +253,17 @@ void DrawQueue::setFrameBuffer(const Rect& dest, const Size& size, const Rect& s
 void DrawQueue::addText(BitmapFontPtr font, const std::string& text, const Rect& screenCoords, Fw::AlignmentFlag align, const Color& color, bool shadow)
 {
     if (!font || text.empty()) return;
-    uint64_t hash = g_text.addText(font, text, screenCoords.size(), align);
-    m_queue.push_back(new DrawQueueItemText(screenCoords.topLeft(), font->getTexture(), hash, color, shadow));
+    TextRenderCachePtr cache = g_text.addText(font, text, screenCoords.size(), align);
+    if (!cache) return;
+    m_queue.push_back(new DrawQueueItemText(screenCoords.topLeft(), font->getTexture(), cache, color, shadow));
 }
 
 void DrawQueue::addColoredText(BitmapFontPtr font, const std::string& text, const Rect& screenCoords, Fw::AlignmentFlag align, const std::vector<std::pair<int, Color>>& colors, bool shadow)
 {
     if (!font || text.empty()) return;
-    uint64_t hash = g_text.addText(font, text, screenCoords.size(), align);
-    m_queue.push_back(new DrawQueueItemTextColored(screenCoords.topLeft(), font->getTexture(), hash, colors, shadow));
+    TextRenderCachePtr cache = g_text.addText(font, text, screenCoords.size(), align);
+    if (!cache) return;
+    m_queue.push_back(new DrawQueueItemTextColored(screenCoords.topLeft(), font->getTexture(), cache, colors, shadow));
 }
 
 void DrawQueue::correctOutfit(const Rect& dest, int fromPos, bool oldScaling)
@@ -290,6 +330,196 @@ void DrawQueue::correctOutfit(const Rect& dest, int fromPos, bool oldScaling)
     }
 }
 
+bool DrawQueue::hashCells(std::vector<uint64_t>& hashes, Size& cells)
+{
+    // clips and rotations can't be combined with the region clip, downscaled framebuffers aren't cell aligned
+    if (!m_useFrameBuffer || m_frameBufferCellSize <= 0 || !m_conditions.empty() || m_scaling < 0.99f)
+        return false;
+
+    const int cellSize = m_frameBufferCellSize;
+    cells = Size((m_frameBufferSize.width() + cellSize - 1) / cellSize, (m_frameBufferSize.height() + cellSize - 1) / cellSize);
+    hashes.assign(cells.area(), 0);
+    m_itemRects.resize(m_queue.size());
+    m_hasOverlays = false;
+
+    for (size_t i = 0; i < m_queue.size(); ++i) {
+        uint64_t itemHash;
+        Rect& dest = m_itemRects[i];
+        if (m_queue[i]->overlay()) {
+            dest = Rect(); // never part of a region
+            m_hasOverlays = true;
+            continue;
+        }
+        if (!m_queue[i]->hash(itemHash, dest))
+            return false;
+        if (!dest.isValid() || dest.right() < 0 || dest.bottom() < 0)
+            continue;
+
+        // the position is hashed relative to the content, so a scrolled item keeps its hash
+        hashCombine(itemHash, ((uint64_t)(uint32_t)(dest.x() + m_frameBufferScroll.x) << 32) | (uint32_t)(dest.y() + m_frameBufferScroll.y));
+        hashCombine(itemHash, ((uint64_t)dest.width() << 32) | (uint32_t)dest.height());
+
+        int left = std::max<int>(dest.left(), 0) / cellSize, top = std::max<int>(dest.top(), 0) / cellSize;
+        int right = std::min<int>(dest.right() / cellSize, cells.width() - 1), bottom = std::min<int>(dest.bottom() / cellSize, cells.height() - 1);
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x)
+                hashCombine(hashes[y * cells.width() + x], itemHash);
+        }
+    }
+    return true;
+}
+
+void DrawQueue::drawRegion(const Rect& region)
+{
+    g_painter->clearRect(Color::black, region);
+    g_painter->setClipRect(region);
+    for (size_t i = 0; i < m_queue.size(); ++i) {
+        if (!m_itemRects[i].intersects(region))
+            continue;
+        if (!m_queue[i]->cache()) {
+            g_drawCache.draw();
+            if (!m_queue[i]->cache())
+                m_queue[i]->draw();
+        }
+        if (g_drawCache.getSize() >= g_drawCache.HALF_MAX_SIZE)
+            g_drawCache.draw();
+    }
+    g_drawCache.draw();
+    g_painter->resetClipRect();
+}
+
+void DrawQueue::drawOverlays()
+{
+    for (auto& item : m_queue) {
+        if (!item->overlay())
+            continue;
+        g_drawCache.draw();
+        item->draw();
+    }
+}
+
+FrameBufferPtr DrawQueueFrameBufferCache::draw(DrawQueue& queue, bool smooth)
+{
+    Size size = queue.getFrameBufferSize();
+    for (auto& frameBuffer : m_frameBuffers) {
+        if (!frameBuffer)
+            frameBuffer = g_framebuffers.createFrameBuffer();
+        frameBuffer->resize(size);
+        frameBuffer->setSmooth(smooth);
+    }
+
+    std::vector<uint64_t> hashes;
+    Size cells;
+    bool hashed = queue.hashCells(hashes, cells);
+    Point scroll = queue.getFrameBufferScroll();
+    int cellSize = queue.getFrameBufferCellSize();
+    Point delta = scroll - m_scroll;
+
+    bool reuse = hashed && m_valid && size == m_size && cells == m_cells && cellSize == m_cellSize &&
+        delta.x % cellSize == 0 && delta.y % cellSize == 0;
+    std::vector<bool> dirty;
+    int dirtyCells = 0;
+    if (reuse) {
+        // partial cells at the far edges were only partly drawn, they can't be scrolled in
+        int lastFullX = size.width() % cellSize ? cells.width() - 2 : cells.width() - 1;
+        int lastFullY = size.height() % cellSize ? cells.height() - 2 : cells.height() - 1;
+        dirty.resize(cells.area());
+        for (int y = 0; y < cells.height(); ++y) {
+            for (int x = 0; x < cells.width(); ++x) {
+                int prevX = x + delta.x / cellSize, prevY = y + delta.y / cellSize;
+                int cell = y * cells.width() + x;
+                dirty[cell] = prevX < 0 || prevY < 0 || prevX > lastFullX || prevY > lastFullY ||
+                    m_hashes[prevY * cells.width() + prevX] != hashes[cell];
+                if (dirty[cell])
+                    dirtyCells += 1;
+            }
+        }
+        // redrawing most of it in pieces costs more than a full redraw
+        if (dirtyCells * 2 > cells.area())
+            reuse = false;
+    }
+
+    if (!reuse) {
+        const FrameBufferPtr& frameBuffer = m_frameBuffers[m_current];
+        frameBuffer->bind();
+        if (hashed) {
+            // kept for the next frame, so without the overlays
+            queue.drawRegion(Rect(0, 0, size));
+        } else {
+            g_painter->clear(Color::black);
+            queue.draw(DRAW_ALL);
+        }
+        frameBuffer->release();
+    } else if (delta != Point(0, 0) || dirtyCells > 0) {
+        const FrameBufferPtr& previous = m_frameBuffers[m_current];
+        if (delta != Point(0, 0))
+            m_current ^= 1;
+        const FrameBufferPtr& frameBuffer = m_frameBuffers[m_current];
+        frameBuffer->bind();
+        if (previous != frameBuffer) {
+            g_painter->setCompositionMode(Painter::CompositionMode_Replace);
+            g_painter->resetColor();
+            previous->draw(Rect(-delta.x, -delta.y, size), Rect(0, 0, size));
+            g_painter->resetCompositionMode();
+        }
+
+        // dirty cells are merged into horizontal runs, equal runs of following rows into one rect
+        std::vector<Rect> regions;
+        for (int y = 0; y < cells.height(); ++y) {
+            for (int x = 0; x < cells.width(); ++x) {
+                if (!dirty[y * cells.width() + x])
+                    continue;
+                int start = x;
+                while (x + 1 < cells.width() && dirty[y * cells.width() + x + 1])
+                    ++x;
+                Rect run(start * cellSize, y * cellSize, (x - start + 1) * cellSize, cellSize);
+                auto it = std::find_if(regions.begin(), regions.end(), [&](const Rect& region) {
+                    return region.left() == run.left() && region.right() == run.right() && region.bottom() + 1 == run.top();
+                });
+                if (it != regions.end())
+                    it->setBottom(run.bottom());
+                else
+                    regions.push_back(run);
+            }
+        }
+        for (const Rect& region : regions)
+            queue.drawRegion(region);
+        g_painter->resetState();
+        frameBuffer->release();
+    }
+
+    m_hashes = std::move(hashes);
+    m_cells = cells;
+    m_size = size;
+    m_scroll = scroll;
+    m_cellSize = cellSize;
+    m_valid = hashed;
+    if (!hashed || !queue.hasOverlays())
+        return m_frameBuffers[m_current];
+
+    // overlays like the light view change every frame anyway, they go over a copy of the reused content
+    if (!m_overlayFrameBuffer)
+        m_overlayFrameBuffer = g_framebuffers.createFrameBuffer();
+    m_overlayFrameBuffer->resize(size);
+    m_overlayFrameBuffer->setSmooth(smooth);
+    m_overlayFrameBuffer->bind();
+    g_painter->setCompositionMode(Painter::CompositionMode_Replace);
+    g_painter->resetColor();
+    m_frameBuffers[m_current]->draw(Rect(0, 0, size), Rect(0, 0, size));
+    g_painter->resetCompositionMode();
+    queue.drawOverlays();
+    g_painter->resetState();
+    m_overlayFrameBuffer->release();
+    return m_overlayFrameBuffer;
+}
+
+void DrawQueueFrameBufferCache::reset()
+{
+    m_frameBuffers[0] = m_frameBuffers[1] = m_overlayFrameBuffer = nullptr;
+    m_hashes.clear();
+    m_valid = false;
+}
+
 void DrawQueue::draw(DrawType drawType)
 {
     size_t start = 0;
@@ -323,17 +553,22 @@ void DrawQueue::draw(DrawType drawType)
     // execute conditions & draw
     for (size_t i = start; i < end; ++i) {
         while (!activeConditions.empty() && activeConditions.top()->m_end <= i) {
+            g_text.flushBatch();
             g_drawCache.draw();
             activeConditions.top()->end(this);
             activeConditions.pop();
         }
         while (condition != m_conditions.end() && (*condition)->m_start <= i) {
+            g_text.flushBatch();
             g_drawCache.draw();
             (*condition)->start(this);
             activeConditions.push(*condition);
             ++condition;
         }
 
+        if (m_queue[i]->batch())
+            continue;
+        g_text.flushBatch();
         if (!m_queue[i]->cache()) {
             g_drawCache.draw();
             if (!m_queue[i]->cache()) { // try to cache again, now g_drawCache should be empty, maybe there's new space
@@ -344,6 +579,7 @@ void DrawQueue::draw(DrawType drawType)
             g_drawCache.draw();
         }
     }
+    g_text.flushBatch();
     g_drawCache.draw();
     // end all actibe conditions
     while (!activeConditions.empty()) {
@@ -26,6 +26,13 @@ struct DrawQueueItem {
     virtual void draw() {}
     virtual void draw(const Point& pos) {}
     virtual bool cache() { return false; }
+    // adds the item to the text batch, which is drawn before the next item that isn't batched
+    virtual bool batch() { return false; }
+    // identifies what the item draws and where, for partial redraws, false if it can't tell
+    virtual bool hash(uint64_t& hash, Rect& dest) { return false; }
+    // covers the whole framebuffer after everything else, partial redraws keep it out of the reused framebuffer
+    // and draw it again every frame
+    virtual bool overlay() { return false; }
 
     TexturePtr m_texture;
     Color m_color;
@@ -40,6 +47,7 @@ struct DrawQueueItemTexturedRect : public DrawQueueItem {
     virtual void draw();
     virtual void draw(const Point& pos);
     virtual bool cache();
+    virtual bool hash(uint64_t& hash, Rect& dest);
 
     Rect m_dest;
     Rect m_src;
@@ -86,6 +94,7 @@ struct DrawQueueItemFilledRect : public DrawQueueItem {
     DrawQueueItemFilledRect(const Rect& rect, const Color& color) :
         DrawQueueItem(nullptr, color), m_dest(rect) {};
     bool cache();
+    bool hash(uint64_t& hash, Rect& dest);
 
     Rect m_dest;
 };
@@ -109,24 +118,25 @@ struct DrawQueueItemFillCoords : public DrawQueueItem {
 };
 
 struct DrawQueueItemText : public DrawQueueItem {
-    DrawQueueItemText(const Point& point, const TexturePtr& texture, uint64_t hash, const Color& color, bool shadow = false) :
-        DrawQueueItem(texture, color), m_point(point), m_hash(hash), m_shadow(shadow)
+    DrawQueueItemText(const Point& point, const TexturePtr& texture, const TextRenderCachePtr& text, const Color& color, bool shadow = false) :
+        DrawQueueItem(texture, color), m_point(point), m_text(text), m_shadow(shadow)
     {};
     void draw();
+    bool batch();
 
     Point m_point;
-    uint64_t m_hash;
+    TextRenderCachePtr m_text;
     bool m_shadow = false;
 };
 
 struct DrawQueueItemTextColored : public DrawQueueItem {
-    DrawQueueItemTextColored(const Point& point, const TexturePtr& texture, uint64_t hash, const std::vector<std::pair<int, Color>>& colors, bool shadow = false) :
-        DrawQueueItem(texture), m_point(point), m_hash(hash), m_colors(colors), m_shadow(shadow)
+    DrawQueueItemTextColored(const Point& point, const TexturePtr& texture, const TextRenderCachePtr& text, const std::vector<std::pair<int, Color>>& colors, bool shadow = false) :
+        DrawQueueItem(texture), m_point(point), m_text(text), m_colors(colors), m_shadow(shadow)
     {};
     void draw();
 
     Point m_point;
-    uint64_t m_hash;
+    TextRenderCachePtr m_text;
     std::vector<std::pair<int, Color>> m_colors;
     bool m_shadow = false;
 };
@@ -280,6 +290,28 @@ public:
     {
         return m_frameBufferSrc;
     }
+    // how far the framebuffer content is scrolled, in whole cells of cellSize pixels
+    void setFrameBufferScroll(const Point& scroll, int cellSize)
+    {
+        m_frameBufferScroll = scroll;
+        m_frameBufferCellSize = cellSize;
+    }
+    Point getFrameBufferScroll()
+    {
+        return m_frameBufferScroll;
+    }
+    int getFrameBufferCellSize()
+    {
+        return m_frameBufferCellSize;
+    }
+
+    // hash of the items drawn into every framebuffer cell, false if the queue can't be drawn partially
+    bool hashCells(std::vector<uint64_t>& hashes, Size& cells);
+    // clears and redraws a region of the framebuffer, needs hashCells to be called first
+    void drawRegion(const Rect& region);
+    // overlay items are left out of the hashes and the regions, they are drawn separately
+    bool hasOverlays() { return m_hasOverlays; }
+    void drawOverlays();
 
     size_t size()
     {
@@ -336,10 +368,34 @@ private:
     bool m_useFrameBuffer = false;
     float m_scaling = 1.f;
     std::string m_shader;
+    Point m_frameBufferScroll;
+    int m_frameBufferCellSize = 0;
+    std::vector<Rect> m_itemRects;
+    bool m_hasOverlays = false;
 
     friend struct DrawQueueConditionMark;
 };
 
-extern std::shared_ptr<DrawQueue> g_drawQueue;
+// keeps the framebuffer of the previous frame, scrolls it with the content and
+// redraws only the cells whose items changed
+class DrawQueueFrameBufferCache {
+public:
+    FrameBufferPtr draw(DrawQueue& queue, bool smooth);
+    void reset();
+
+private:
+    FrameBufferPtr m_frameBuffers[2];
+    FrameBufferPtr m_overlayFrameBuffer; // reused content with the overlays drawn over it
+    int m_current = 0;
+    std::vector<uint64_t> m_hashes;
+    Size m_cells;
+    Size m_size;
+    Point m_scroll;
+    int m_cellSize = 0;
+    bool m_valid = false;
+};
+
+// every thread building a draw queue has its own
+extern thread_local std::shared_ptr<DrawQueue> g_drawQueue;
 
 #endif
\ No newline at end of file
@@ -65,6 +65,14 @@ void Graphics::init()
     }
 
     GLenum err = glewInit();
+#if defined(HEADLESS_WINDOW) && defined(GLEW_ERROR_NO_GLX_DISPLAY)
+    // a GLEW built for GLX (the usual distro package) loads every function and then fails to find a GLX
+    // display, the loaded functions still reach the current EGL context through the shared GL dispatch
+    if(err == GLEW_ERROR_NO_GLX_DISPLAY && g_window.getPlatformType() == "HEADLESS-EGL") {
+        g_logger.info("GLEW has no GLX display, using it with the headless EGL context");
+        err = GLEW_OK;
+    }
+#endif
     if(err != GLEW_OK)
         g_logger.fatal(stdext::format("Unable to init GLEW: %s", glewGetErrorString(err)));
 
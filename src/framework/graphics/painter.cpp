@@ -61,10 +61,11 @@ Painter::Painter()
     m_drawOutfitLayersProgram = PainterShaderProgram::create("drawOutfitLayersProgram", glslOutfitVertexShader, glslOutfitFragmentShader, true);
     m_drawNewProgram = PainterShaderProgram::create("drawNewProgram", newVertexShader, newFragmentShader);
     m_drawTextProgram = PainterShaderProgram::create("drawTextProgram", textVertexShader, textFragmentShader);
+    m_drawColoredTextProgram = PainterShaderProgram::create("drawColoredTextProgram", coloredTextVertexShader, coloredTextFragmentShader);
     m_drawLineProgram = PainterShaderProgram::create("drawLineProgram", lineVertexShader, lineFragmentShader);
 
     if (!m_drawTexturedProgram || !m_drawSolidColorProgram || !m_drawSolidColorOnTextureProgram || !m_drawOutfitLayersProgram ||
-        !m_drawNewProgram || !m_drawTextProgram || !m_drawLineProgram) {
+        !m_drawNewProgram || !m_drawTextProgram || !m_drawColoredTextProgram || !m_drawLineProgram) {
         g_logger.fatal("Can't setup default shaders, check log file for details");
     }
 
@@ -72,6 +73,11 @@ Painter::Painter()
     g_graphics.checkForError(__FUNCTION__, __FILE__, __LINE__);
 }
 
+Painter::~Painter()
+{
+    delete m_streamBuffer;
+}
+
 void Painter::bind()
 {
     refreshState();
@@ -553,6 +559,11 @@ void Painter::drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& te
     if (texture && texture->isEmpty())
         return;
 
+    if (colors && !m_shaderProgram) { // colored text, draw it with per vertex colors in a single call
+        drawText(Point(0, 0), coordsBuffer, *colors, texture);
+        return;
+    }
+
     setDrawProgram(m_shaderProgram ? m_shaderProgram : m_drawTexturedProgram.get());
     setTexture(texture);
     drawCoords(coordsBuffer, Painter::Triangles, nullptr, colors);
@@ -659,40 +670,79 @@ void Painter::drawText(const Point& pos, CoordsBuffer& coordsBuffer, const Color
 
 void Painter::drawText(const Point& pos, CoordsBuffer& coordsBuffer, const std::vector<std::pair<int, Color>>& colors, const TexturePtr& texture)
 {
+    // color runs are given as (end glyph, color), expand them to one color per vertex, 6 vertices per glyph
+    int vertexCount = coordsBuffer.getVertexCount();
+    m_streamColors.resize(vertexCount * 4);
+    int vertex = 0;
+    for (auto& cp : colors) {
+        float color[4] = { cp.second.rF(), cp.second.gF(), cp.second.bF(), cp.second.aF() };
+        for (int end = std::min<int>(cp.first * 6, vertexCount); vertex < end; ++vertex)
+            memcpy(m_streamColors.data() + vertex * 4, color, sizeof(color));
+    }
+    if (vertex == 0)
+        return;
+
     setTexture(texture);
     // update shader with the current painter state
-    m_drawTextProgram->bind();
-    m_drawTextProgram->setTransformMatrix(m_transformMatrix);
-    m_drawTextProgram->setProjectionMatrix(m_projectionMatrix);
-    m_drawTextProgram->setTextureMatrix(m_textureMatrix);
-    m_drawTextProgram->setOffset(pos);
+    m_drawColoredTextProgram->bind();
+    m_drawColoredTextProgram->setTransformMatrix(m_transformMatrix);
+    m_drawColoredTextProgram->setProjectionMatrix(m_projectionMatrix);
+    m_drawColoredTextProgram->setTextureMatrix(m_textureMatrix);
+    m_drawColoredTextProgram->setOffset(pos);
 
     HardwareBuffer* hardwareCache = coordsBuffer.getVertexHardwareCache();
     if (hardwareCache) {
         hardwareCache->bind();
-        m_drawTextProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, nullptr, 2);
+        m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, nullptr, 2);
         HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
     } else {
-        m_drawTextProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, coordsBuffer.getVertexArray(), 2);
+        m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, coordsBuffer.getVertexArray(), 2);
     }
 
     HardwareBuffer* texHardwareCache = coordsBuffer.getTextureHardwareCache();
     if (texHardwareCache) {
         texHardwareCache->bind();
-        m_drawTextProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, nullptr, 2);
+        m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, nullptr, 2);
         HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
     } else {
-        m_drawTextProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, coordsBuffer.getTextureCoordArray(), 2);
+        m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, coordsBuffer.getTextureCoordArray(), 2);
     }
 
-    int s = 0;
-    for (auto& cp : colors) {
-        m_drawTextProgram->setColor(cp.second);
-        glDrawArrays(GL_TRIANGLES, s * 6, (cp.first - s) * 6);
-        s = cp.first;
-    }
-    m_draws += coordsBuffer.getVertexCount();
-    m_calls += colors.size();
+    PainterShaderProgram::enableAttributeArray(PainterShaderProgram::COLOR_ATTR);
+    writeStreamBuffer(m_streamColors.data(), vertex * 4 * sizeof(float));
+    m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::COLOR_ATTR, nullptr, 4);
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+
+    glDrawArrays(GL_TRIANGLES, 0, vertex);
+    m_draws += vertex;
+    m_calls += 1;
+
+    PainterShaderProgram::disableAttributeArray(PainterShaderProgram::COLOR_ATTR);
+}
+
+void Painter::drawTextBatch(const std::vector<float>& vertices, int size, const TexturePtr& texture)
+{
+    setTexture(texture);
+    m_drawColoredTextProgram->bind();
+    m_drawColoredTextProgram->setTransformMatrix(m_transformMatrix);
+    m_drawColoredTextProgram->setProjectionMatrix(m_projectionMatrix);
+    m_drawColoredTextProgram->setTextureMatrix(m_textureMatrix);
+    m_drawColoredTextProgram->setOffset(Point(0, 0));
+
+    PainterShaderProgram::enableAttributeArray(PainterShaderProgram::COLOR_ATTR);
+
+    const int stride = 8 * sizeof(float);
+    writeStreamBuffer(vertices.data(), size * stride);
+    m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, (const float*)0, 2, stride);
+    m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, (const float*)(2 * sizeof(float)), 2, stride);
+    m_drawColoredTextProgram->setAttributeArray(PainterShaderProgram::COLOR_ATTR, (const float*)(4 * sizeof(float)), 4, stride);
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+
+    glDrawArrays(GL_TRIANGLES, 0, size);
+    m_draws += size;
+    m_calls += 1;
+
+    PainterShaderProgram::disableAttributeArray(PainterShaderProgram::COLOR_ATTR);
 }
 
 void Painter::drawLine(const std::vector<float>& vertex, int size, int width)
@@ -747,7 +797,17 @@ void Painter::setOffset(const Point& offset)
     m_shaderProgram->setOffset(offset);
 }
 
-void Painter::drawCache(const std::vector<float>& vertex, const std::vector<float>& texture, const std::vector<float>& color, int size)
+void Painter::writeStreamBuffer(const void* data, int bytes)
+{
+    // re-specifying the whole store orphans the previous one, so the driver never waits for the gpu to finish
+    // reading it, the buffer is left bound for setting attribute pointers
+    if (!m_streamBuffer)
+        m_streamBuffer = new HardwareBuffer(HardwareBuffer::VertexBuffer);
+    m_streamBuffer->bind();
+    m_streamBuffer->write(const_cast<void*>(data), bytes, HardwareBuffer::StreamDraw);
+}
+
+void Painter::drawCache(const std::vector<float>& vertices, int size)
 {
     setTexture(g_atlas.get(0)); // todo: remove it
     // update shader with the current painter state
@@ -758,9 +818,13 @@ void Painter::drawCache(const std::vector<float>& vertex, const std::vector<floa
 
     PainterShaderProgram::enableAttributeArray(PainterShaderProgram::COLOR_ATTR);
 
-    m_drawNewProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, vertex.data(), 2);
-    m_drawNewProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, texture.data(), 2);
-    m_drawNewProgram->setAttributeArray(PainterShaderProgram::COLOR_ATTR, color.data(), 4);
+    // the whole cache goes to the gpu in one write
+    const int stride = 8 * sizeof(float);
+    writeStreamBuffer(vertices.data(), size * stride);
+    m_drawNewProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, (const float*)0, 2, stride);
+    m_drawNewProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, (const float*)(2 * sizeof(float)), 2, stride);
+    m_drawNewProgram->setAttributeArray(PainterShaderProgram::COLOR_ATTR, (const float*)(4 * sizeof(float)), 4, stride);
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
 
     glDrawArrays(GL_TRIANGLES, 0, size);
     m_draws += size;
@@ -83,7 +83,7 @@ public:
     };
 
     Painter();
-    ~Painter() {}
+    ~Painter();
 
     void bind();
     void unbind();
@@ -148,6 +148,7 @@ public:
 
     void drawText(const Point& pos, CoordsBuffer& coordsBuffer, const Color& color, const TexturePtr& texture);
     void drawText(const Point& pos, CoordsBuffer& coordsBuffer, const std::vector<std::pair<int, Color>>& colors, const TexturePtr& texture);
+    void drawTextBatch(const std::vector<float>& vertices, int size, const TexturePtr& texture);
 
     void drawLine(const std::vector<float>& vertex, int size, int width = 1);
 
@@ -155,7 +156,8 @@ public:
     void setOffset(const Point& offset);
 
     void setAtlasTextures(const TexturePtr& atlas);
-    void drawCache(const std::vector<float>& vertex, const std::vector<float>& texture, const std::vector<float>& color, int size);
+    // vertices are interleaved as x, y, u, v, r, g, b, a
+    void drawCache(const std::vector<float>& vertices, int size);
 
     void setColor(const Color& color) { m_color = color; }
     void setShaderProgram(const PainterShaderProgramPtr& shaderProgram) { setShaderProgram(shaderProgram.get()); }
@@ -207,6 +209,7 @@ protected:
     void updateGlClipRect();
     void updateGlAlphaWriting();
     void updateGlViewport();
+    void writeStreamBuffer(const void* data, int bytes);
 #ifdef WITH_DEPTH_BUFFER
     void updateDepthFunc();
 #endif
@@ -251,7 +254,12 @@ private:
     PainterShaderProgramPtr m_drawNewProgram;
 
     PainterShaderProgramPtr m_drawTextProgram;
+    PainterShaderProgramPtr m_drawColoredTextProgram;
     PainterShaderProgramPtr m_drawLineProgram;
+
+    // vertex buffer re-specified on every write, used for data that changes each draw
+    HardwareBuffer* m_streamBuffer = nullptr;
+    std::vector<float> m_streamColors;
 };
 
 extern Painter* g_painter;
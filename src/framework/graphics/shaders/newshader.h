@@ -37,6 +37,24 @@ static const std::string textVertexShader = "\n\
         v_TexCoord = (u_TextureMatrix * vec3(a_TexCoord,1.0)).xy;\n\
     }\n";
 
+// COLORED TEXT
+static const std::string coloredTextVertexShader = "\n\
+    attribute vec2 a_TexCoord;\n\
+    attribute vec4 a_Color;\n\
+    uniform mat3 u_TextureMatrix;\n\
+    varying vec2 v_TexCoord;\n\
+    varying vec4 v_Color;\n\
+    attribute vec2 a_Vertex;\n\
+    uniform mat3 u_TransformMatrix;\n\
+    uniform mat3 u_ProjectionMatrix;\n\
+    uniform vec2 u_Offset;\n\
+    void main()\n\
+    {\n\
+        gl_Position = vec4((u_ProjectionMatrix * u_TransformMatrix * vec3(a_Vertex.xy + u_Offset, 1.0)).xy, 1.0, 1.0);\n\
+        v_TexCoord = (u_TextureMatrix * vec3(a_TexCoord,1.0)).xy;\n\
+        v_Color = a_Color;\n\
+    }\n";
+
 // LINE
 static const std::string lineVertexShader = "\n\
     attribute vec2 a_Vertex;\n\
@@ -68,6 +86,16 @@ static const std::string textFragmentShader = "\n\
         gl_FragColor = texture2D(u_Tex0, v_TexCoord) * u_Color;\n\
     }\n";
 
+// COLORED TEXT
+static const std::string coloredTextFragmentShader = "\n\
+    varying vec2 v_TexCoord;\n\
+    varying vec4 v_Color;\n\
+    uniform sampler2D u_Tex0;\n\
+    void main()\n\
+    {\n\
+        gl_FragColor = texture2D(u_Tex0, v_TexCoord) * v_Color;\n\
+    }\n";
+
 // LINE
 static const std::string lineFragmentShader = "\n\
     uniform vec4 u_Color;\n\
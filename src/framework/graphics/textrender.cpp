@@ -1,5 +1,6 @@
 #include "painter.h"
 #include "textrender.h"
+#include "drawcache.h"
 #include <framework/core/logger.h>
 #include <framework/core/eventdispatcher.h>
 
@@ -12,8 +13,10 @@ void TextRender::init()
 
 void TextRender::terminate()
 {
-    for (auto& cache : m_cache) {
-        cache.clear();
+    for (int i = 0; i < INDEXES; ++i) {
+        std::lock_guard<std::mutex> lock(m_mutex[i]);
+        m_cache[i].clear();
+        m_memory[i] = 0;
     }
 }
 
@@ -23,30 +26,36 @@ void TextRender::poll()
     int index = (iteration++) % INDEXES;
     std::lock_guard<std::mutex> lock(m_mutex[index]);
     auto& cache = m_cache[index];
-    if (cache.size() < 100)
+    if (m_memory[index] <= MAX_MEMORY / INDEXES)
         return;
 
-    ticks_t dropPoint = g_clock.millis();
-    if (cache.size() > 500)
-        dropPoint -= 10;
-    else if (cache.size() > 250)
-        dropPoint -= 100;
-    else
-        dropPoint -= 1000;
-
-    for (auto it = cache.begin(); it != cache.end(); ) {
-        if (it->second->lastUse < dropPoint) {
-            it = cache.erase(it);
-            continue;
-        }
-        ++it;
+    // drop the least recently used texts until a quarter of the index budget is free, so it doesn't run every poll,
+    // texts still waiting in a draw queue stay alive until they're drawn
+    std::vector<std::multimap<uint64_t, TextRenderCachePtr>::iterator> entries;
+    entries.reserve(cache.size());
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+        entries.push_back(it);
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a->second->lastUse < b->second->lastUse; });
+
+    ticks_t now = g_clock.millis();
+    for (auto& it : entries) {
+        if (m_memory[index] <= MAX_MEMORY / INDEXES * 3 / 4 || it->second->lastUse >= now)
+            break;
+        m_memory[index] -= estimateMemory(it->second);
+        cache.erase(it);
     }
 }
 
-uint64_t TextRender::addText(BitmapFontPtr font, const std::string& text, const Size& size, Fw::AlignmentFlag align)
+size_t TextRender::estimateMemory(const TextRenderCachePtr& text)
+{
+    // every glyph is 2 triangles with vertex and texture coords, on the cpu and in the hardware buffer
+    return sizeof(TextRenderCache) + text->text.size() * (1 + 6 * 4 * sizeof(float) * 2);
+}
+
+TextRenderCachePtr TextRender::addText(BitmapFontPtr font, const std::string& text, const Size& size, Fw::AlignmentFlag align)
 {
     if (!font || text.empty() || !size.isValid()) 
-        return 0;
+        return nullptr;
     uint64_t hash = 1125899906842597ULL;
     for (size_t i = 0; i < text.length(); ++i) {
         hash = hash * 31 + text[i];
@@ -57,73 +66,107 @@ uint64_t TextRender::addText(BitmapFontPtr font, const std::string& text, const
     hash = hash * 31 + (uint64_t)font->getId();
 
     int index = hash % INDEXES;
-    m_mutex[index].lock();
-    auto it = m_cache[index].find(hash);
-    if (it == m_cache[index].end()) {
-        m_cache[index][hash] = std::shared_ptr<TextRenderCache>(new TextRenderCache{ font, text, size, align, font->getTexture(), CoordsBuffer(), g_clock.millis() });
+    std::lock_guard<std::mutex> lock(m_mutex[index]);
+    auto range = m_cache[index].equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->matches(font, text, size, align)) {
+            it->second->lastUse = g_clock.millis();
+            return it->second;
+        }
     }
-    m_mutex[index].unlock();
-    return hash;
+    auto cache = std::make_shared<TextRenderCache>(font, text, size, align);
+    m_cache[index].emplace_hint(range.second, hash, cache);
+    m_memory[index] += estimateMemory(cache);
+    return cache;
 }
 
 void TextRender::drawText(const Rect& rect, const std::string& text, BitmapFontPtr font, const Color& color, Fw::AlignmentFlag align, bool shadow)
 {
     VALIDATE_GRAPHICS_THREAD();
-    uint64_t hash = addText(font, text, rect.size(), align);
-    drawText(rect.topLeft(), hash, color, shadow);
+    drawText(rect.topLeft(), addText(font, text, rect.size(), align), color, shadow);
 }
 
-void TextRender::drawText(const Point& pos, uint64_t hash, const Color& color, bool shadow)
+void TextRender::calculateCoords(const TextRenderCachePtr& text)
+{
+    // only the graphics thread touches the coords, the entry is owned by the draw queue item so there's no lookup
+    if (text->calculated)
+        return;
+    text->font->calculateDrawTextCoords(text->coords, text->text, Rect(0, 0, text->size), text->align);
+    text->coords.cache();
+    text->calculated = true;
+}
+
+void TextRender::drawText(const Point& pos, const TextRenderCachePtr& text, const Color& color, bool shadow)
 {
     VALIDATE_GRAPHICS_THREAD();
-    int index = hash % INDEXES;
-    m_mutex[index].lock();
-    auto _it = m_cache[index].find(hash);
-    if (_it == m_cache[index].end()) {
-        m_mutex[index].unlock();
+    if (!text)
         return;
-    }
-    auto it = _it->second;
-    it->lastUse = g_clock.millis();
-    m_mutex[index].unlock();
-    if (it->font) { // calculate text coords
-        it->font->calculateDrawTextCoords(it->coords, it->text, Rect(0, 0, it->size), it->align);
-        it->coords.cache();
-        it->text.clear();
-        it->font.reset();
-    }
+    calculateCoords(text);
 
     if (shadow) {
         auto shadowPos = Point(pos);
         shadowPos.x += 1;
         shadowPos.y += 1;
-        g_painter->drawText(shadowPos, it->coords, Color::black, it->texture);
+        g_painter->drawText(shadowPos, text->coords, Color::black, text->texture);
     }
 
-    g_painter->drawText(pos, it->coords, color, it->texture);
+    g_painter->drawText(pos, text->coords, color, text->texture);
 }
 
-void TextRender::drawColoredText(const Point& pos, uint64_t hash, const std::vector<std::pair<int, Color>>& colors, bool shadow)
+void TextRender::drawColoredText(const Point& pos, const TextRenderCachePtr& text, const std::vector<std::pair<int, Color>>& colors, bool shadow)
 {
     VALIDATE_GRAPHICS_THREAD();
     if (colors.empty())
-        return drawText(pos, hash, Color::white);
-    int index = hash % INDEXES;
-    m_mutex[index].lock();
-    auto _it = m_cache[index].find(hash);
-    if (_it == m_cache[index].end()) {
-        m_mutex[index].unlock();
+        return drawText(pos, text, Color::white);
+    if (!text)
         return;
+    calculateCoords(text);
+    g_painter->drawText(pos, text->coords, colors, text->texture);
+}
+
+void TextRender::batchText(const Point& pos, const TextRenderCachePtr& text, const Color& color, bool shadow)
+{
+    VALIDATE_GRAPHICS_THREAD();
+    if (!text)
+        return;
+    calculateCoords(text);
+
+    if (m_batchTexture != text->texture) {
+        flushBatch();
+        m_batchTexture = text->texture;
     }
-    auto it = _it->second;
-    it->lastUse = g_clock.millis();
-    m_mutex[index].unlock();
-    if (it->font) { // calculate text coords
-        it->font->calculateDrawTextCoords(it->coords, it->text, Rect(0, 0, it->size), it->align);
-        it->coords.cache();
-        it->text.clear();
-        it->font.reset();
-    }
-    g_painter->drawText(pos, it->coords, colors, it->texture);
+    if (m_batchSize == 0)
+        g_drawCache.draw(); // everything queued before the first text is below it
+
+    int vertexCount = text->coords.getVertexCount();
+    const float* vertices = text->coords.getVertexArray();
+    const float* texCoords = text->coords.getTextureCoordArray();
+    auto addText = [&](const Point& offset, const Color& textColor) {
+        // interleaved as x, y, u, v, r, g, b, a like the draw cache
+        m_batchVertices.resize((m_batchSize + vertexCount) * 8);
+        float* dest = m_batchVertices.data() + m_batchSize * 8;
+        for (int i = 0; i < vertexCount; ++i, dest += 8) {
+            dest[0] = vertices[i * 2] + offset.x;
+            dest[1] = vertices[i * 2 + 1] + offset.y;
+            dest[2] = texCoords[i * 2];
+            dest[3] = texCoords[i * 2 + 1];
+            dest[4] = textColor.rF();
+            dest[5] = textColor.gF();
+            dest[6] = textColor.bF();
+            dest[7] = textColor.aF();
+        }
+        m_batchSize += vertexCount;
+    };
+    if (shadow)
+        addText(pos + Point(1, 1), Color::black);
+    addText(pos, color);
+}
+
+void TextRender::flushBatch()
+{
+    if (m_batchSize == 0)
+        return;
+    g_painter->drawTextBatch(m_batchVertices, m_batchSize, m_batchTexture);
+    m_batchSize = 0;
 }
 
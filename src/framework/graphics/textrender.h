@@ -7,30 +7,59 @@
 #include "coordsbuffer.h"
 #include <framework/core/clock.h>
 
+// layout of one text, shared by every widget, static text or animated text drawing the same string
 struct TextRenderCache {
-    BitmapFontPtr font;
-    std::string text;
-    Size size;
-    Fw::AlignmentFlag align;
-    TexturePtr texture;
+    TextRenderCache(const BitmapFontPtr& font, const std::string& text, const Size& size, Fw::AlignmentFlag align) :
+        font(font), text(text), size(size), align(align), texture(font->getTexture()), lastUse(g_clock.millis()) {}
+
+    bool matches(const BitmapFontPtr& otherFont, const std::string& otherText, const Size& otherSize, Fw::AlignmentFlag otherAlign) const
+    {
+        return font == otherFont && size == otherSize && align == otherAlign && text == otherText;
+    }
+
+    // the key, never changes so it can be compared from any thread
+    const BitmapFontPtr font;
+    const std::string text;
+    const Size size;
+    const Fw::AlignmentFlag align;
+    const TexturePtr texture;
+
+    // text coords, calculated by the graphics thread when the text is drawn for the first time
     CoordsBuffer coords;
+    bool calculated = false;
+
+    // guarded by the mutex of the cache index
     ticks_t lastUse;
 };
 
 class TextRender
 {
     static const int INDEXES = 10;
+    // approximated memory limit of the cache, the least recently used texts are removed first
+    static const size_t MAX_MEMORY = 8 * 1024 * 1024;
 public:
     void init();
     void terminate();
     void poll();
-    uint64_t addText(BitmapFontPtr font, const std::string& text, const Size& size, Fw::AlignmentFlag align = Fw::AlignTopLeft);
+    TextRenderCachePtr addText(BitmapFontPtr font, const std::string& text, const Size& size, Fw::AlignmentFlag align = Fw::AlignTopLeft);
     void drawText(const Rect& rect, const std::string& text, BitmapFontPtr font, const Color& color = Color::white, Fw::AlignmentFlag align = Fw::AlignTopLeft, bool shadow = false);
-    void drawText(const Point& pos, uint64_t hash, const Color& color, bool shadow = false);
-    void drawColoredText(const Point& pos, uint64_t hash, const std::vector<std::pair<int, Color>>& colors, bool shadow = false);
+    void drawText(const Point& pos, const TextRenderCachePtr& text, const Color& color, bool shadow = false);
+    void drawColoredText(const Point& pos, const TextRenderCachePtr& text, const std::vector<std::pair<int, Color>>& colors, bool shadow = false);
+
+    // texts of one font drawn one after another are merged into a single draw call
+    void batchText(const Point& pos, const TextRenderCachePtr& text, const Color& color, bool shadow = false);
+    void flushBatch();
 
 private:
-    std::map<uint64_t, std::shared_ptr<TextRenderCache>> m_cache[INDEXES];
+    void calculateCoords(const TextRenderCachePtr& text);
+    static size_t estimateMemory(const TextRenderCachePtr& text);
+
+    std::vector<float> m_batchVertices;
+    int m_batchSize = 0;
+    TexturePtr m_batchTexture;
+    // texts with colliding hashes are kept next to each other and told apart by their keys
+    std::multimap<uint64_t, TextRenderCachePtr> m_cache[INDEXES];
+    size_t m_memory[INDEXES] = { 0 };
     std::mutex m_mutex[INDEXES];
 };
 
@@ -30,7 +30,7 @@
 #include <framework/util/stats.h>
 #include <framework/graphics/texturemanager.h>
 
-uint Texture::uniqueId = 1;
+std::atomic<uint> Texture::uniqueId(1);
 
 Texture::Texture(const Size& size, bool depthTexture, bool smooth, bool upsideDown)
 {
@@ -74,6 +74,12 @@ Texture::~Texture()
 void Texture::replace(const ImagePtr& image)
 {
     m_uniqueId = uniqueId++;
+    if (m_id != 0 && image && image->getSize() == m_size && !m_hasMipmaps && !m_buildHardwareMipmaps) {
+        // same size, keep the texture storage and upload the new pixels on next update
+        m_image = image;
+        m_needsUpdate = true;
+        return;
+    }
     if (m_id != 0) { // free existing texture from gl memory
         GLuint textureId = m_id;
         g_graphicsDispatcher.addEvent([textureId] {
@@ -119,6 +125,9 @@ void Texture::update()
         m_image = nullptr; // free image
         m_needsUpdate = true;
         g_graphics.checkForError(__FUNCTION__, __FILE__, __LINE__);
+    } else if (m_image) { // replaced by an image of the same size
+        updatePixels(Rect(Point(0, 0), m_image->getSize()), m_image->getPixelData(), m_image->getBpp());
+        m_image = nullptr;
     }
     
     if (m_needsUpdate) {
@@ -210,7 +219,16 @@ void Texture::setupTranformMatrix()
     }
 }
 
-void Texture::setupPixels(int level, const Size& size, uchar* pixels, int channels, bool compress)
+void Texture::updatePixels(const Rect& rect, const uchar* pixels, int channels)
+{
+    if (m_id == 0)
+        update();
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(), pixelFormat(channels), GL_UNSIGNED_BYTE, pixels);
+    g_graphics.checkForError(__FUNCTION__, __FILE__, __LINE__);
+}
+
+GLenum Texture::pixelFormat(int channels)
 {
     GLenum format = 0;
     switch(channels) {
@@ -227,7 +245,11 @@ void Texture::setupPixels(int level, const Size& size, uchar* pixels, int channe
             format = GL_LUMINANCE;
             break;
     }
+    return format;
+}
 
+void Texture::setupPixels(int level, const Size& size, uchar* pixels, int channels, bool compress)
+{
     GLenum internalFormat = GL_RGBA;
-    glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, format, GL_UNSIGNED_BYTE, pixels);
+    glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, pixelFormat(channels), GL_UNSIGNED_BYTE, pixels);
 }
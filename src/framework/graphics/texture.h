@@ -27,13 +27,14 @@
 
 class Texture : public stdext::shared_object
 {
-    static uint uniqueId;
 public:
     Texture(const Size& size, bool depthTexture = false, bool smooth = false, bool upsideDown = false);
     Texture(const ImagePtr& image, bool buildMipmaps = false, bool compress = false, bool smooth = false);
     virtual ~Texture();
     virtual void replace(const ImagePtr& image);
     void resize(const Size& size);
+    // updates part of the texture in place without reallocating its storage, render thread only
+    void updatePixels(const Rect& rect, const uchar* pixels, int channels = 4);
 
     // update must be called always before drawing, only this function can use opengl functions
     virtual void update();
@@ -62,6 +63,7 @@ public:
     virtual bool isAnimatedTexture() { return false; }
 
 protected:
+    static std::atomic<uint> uniqueId;
 
     void uploadPixels(const ImagePtr& image, bool buildMipmaps = false, bool compress = false);
 
@@ -70,6 +72,7 @@ protected:
     void setupFilters();
     void setupTranformMatrix();
     void setupPixels(int level, const Size& size, uchar *pixels, int channels = 4, bool compress = false);
+    static GLenum pixelFormat(int channels);
 
     uint m_id = 0;
     uint m_uniqueId = 0;
@@ -28,6 +28,7 @@
 #include <framework/core/resourcemanager.h>
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/graphics/apngloader.h>
 #include <framework/util/stats.h>
 
@@ -35,25 +36,31 @@ TextureManager g_textures;
 
 void TextureManager::init()
 {
+    m_releaseIdleEvent = g_dispatcher.cycleEvent(std::bind(&TextureManager::releaseIdleAnimations, this), 5000);
 }
 
 void TextureManager::terminate()
 {
-    m_textures.clear();
-    m_animatedTextures.clear();
+    if(m_releaseIdleEvent) {
+        m_releaseIdleEvent->cancel();
+        m_releaseIdleEvent = nullptr;
+    }
+    clearCache();
 }
 
 void TextureManager::clearCache()
 {
-    m_animatedTextures.clear();
     m_textures.clear();
+    m_texturePaths.clear();
+    m_pendingTextures.clear();
+    m_memoryUsage = 0;
 }
 
 void TextureManager::reload()
 {
     for(auto& it : m_textures) {
         const std::string& path = g_resources.guessFilePath(it.first, "png");
-        const TexturePtr& tex = it.second;
+        const TexturePtr& tex = it.second.texture;
 
         ImagePtr image = Image::load(path);
         if(!image)
@@ -63,44 +70,86 @@ void TextureManager::reload()
     }
 }
 
-TexturePtr TextureManager::getTexture(const std::string& fileName)
+void TextureManager::preloadAsync(const std::string& fileName)
 {
-    auto it = m_textures.find(fileName);
-    if (it != m_textures.end()) {
-        return it->second;
-    }
+    std::string filePath = g_resources.resolvePath(fileName);
+    if(m_textures.find(filePath) != m_textures.end() || m_pendingTextures.find(filePath) != m_pendingTextures.end())
+        return;
 
-    TexturePtr texture;
+    // only reading and decoding happen in the background, the texture is created by getTexture
+    std::string filePathEx = g_resources.guessFilePath(filePath, "png");
+    m_pendingTextures[filePath] = g_asyncDispatcher.schedule([filePathEx, filePath] {
+        DecodedTexture decoded;
+        try {
+            std::stringstream fin;
+            g_resources.readFileStream(filePathEx, fin);
+            decoded = decodeTexture(fin, filePath);
+        } catch(stdext::exception& e) {
+            g_logger.error(stdext::format("Unable to load texture '%s': %s", filePath, e.what()));
+        }
+        return decoded;
+    });
+}
 
-    // before must resolve filename to full path
-    std::string filePath = g_resources.resolvePath(fileName);
+TexturePtr TextureManager::getTexture(const std::string& fileName)
+{
+    std::string filePath;
+    auto pathIt = m_texturePaths.find(fileName);
+    if(pathIt != m_texturePaths.end())
+        filePath = pathIt->second;
+    else // before must resolve filename to full path
+        filePath = g_resources.resolvePath(fileName);
 
     // check if the texture is already loaded
-    it = m_textures.find(filePath);
+    auto it = m_textures.find(filePath);
     if(it != m_textures.end()) {
-        texture = it->second;
+        if(pathIt == m_texturePaths.end()) {
+            m_texturePaths[fileName] = filePath;
+            it->second.names.push_back(fileName);
+        }
+        it->second.lastUse = g_clock.millis();
+        return it->second.texture;
     }
 
     // texture not found, load it
-    if(!texture) {
-        try {
+    TexturePtr texture;
+    DecodedTexture decoded;
+    try {
+        auto pendingIt = m_pendingTextures.find(filePath);
+        if(pendingIt != m_pendingTextures.end()) {
+            // already being decoded by preloadAsync
+            decoded = pendingIt->second.get();
+            m_pendingTextures.erase(pendingIt);
+        } else {
             std::string filePathEx = g_resources.guessFilePath(filePath, "png");
 
             // load texture file data
             std::stringstream fin;
             g_resources.readFileStream(filePathEx, fin);
-            texture = loadTexture(fin, filePath);
-        } catch(stdext::exception& e) {
-            g_logger.error(stdext::format("Unable to load texture '%s': %s", fileName, e.what()));
-            texture = nullptr;
+            decoded = decodeTexture(fin, filePath);
         }
+        texture = createTexture(decoded);
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to load texture '%s': %s", fileName, e.what()));
+        texture = nullptr;
+    }
 
-        if(texture) {
-            texture->setTime(stdext::time());
-            texture->setSmooth(true);
-            m_textures[filePath] = texture;
-            m_textures[fileName] = texture;
+    if(texture) {
+        texture->setTime(stdext::time());
+        texture->setSmooth(true);
+
+        CachedTexture& cached = m_textures[filePath];
+        cached.texture = texture;
+        cached.memory = (uint64)decoded.size.area() * 4 * decoded.frames.size();
+        cached.lastUse = g_clock.millis();
+        cached.names.push_back(filePath);
+        m_texturePaths[filePath] = filePath;
+        if(fileName != filePath) {
+            cached.names.push_back(fileName);
+            m_texturePaths[fileName] = filePath;
         }
+        m_memoryUsage += cached.memory;
+        trimCache();
     }
 
     return texture;
@@ -108,7 +157,60 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
 
 TexturePtr TextureManager::loadTexture(std::stringstream& file, const std::string& source)
 {
-    TexturePtr texture;
+    return createTexture(decodeTexture(file, source));
+}
+
+void TextureManager::setMemoryBudget(int megabytes)
+{
+    m_memoryBudget = (uint64)std::max<int>(megabytes, 0) * 1024 * 1024;
+    trimCache();
+}
+
+void TextureManager::trimCache()
+{
+    if(m_memoryUsage <= m_memoryBudget)
+        return;
+
+    // only textures no one else holds can be dropped, least recently used first
+    std::vector<std::pair<ticks_t, std::string>> unused;
+    for(auto& it : m_textures) {
+        if(it.second.texture->ref_count() == 1)
+            unused.push_back(std::make_pair(it.second.lastUse, it.first));
+    }
+    std::sort(unused.begin(), unused.end());
+
+    for(auto& it : unused) {
+        if(m_memoryUsage <= m_memoryBudget)
+            break;
+
+        auto textureIt = m_textures.find(it.second);
+        for(const std::string& name : textureIt->second.names)
+            m_texturePaths.erase(name);
+        m_memoryUsage -= textureIt->second.memory;
+        m_textures.erase(textureIt);
+        m_evictedTextures++;
+    }
+}
+
+void TextureManager::releaseIdleAnimations()
+{
+    // animations keep their frames in memory, only the uploaded frame is dropped until drawn again
+    const ticks_t idleTime = 10000;
+    for(auto& it : m_textures) {
+        if(!it.second.texture->isAnimatedTexture())
+            continue;
+        AnimatedTexturePtr animatedTexture = it.second.texture->static_self_cast<AnimatedTexture>();
+        if(!animatedTexture->hasGpuStorage() || g_clock.millis() - animatedTexture->getLastDraw() < idleTime)
+            continue;
+        g_graphicsDispatcher.addEvent([animatedTexture, idleTime] {
+            animatedTexture->releaseIfIdle(idleTime);
+        });
+    }
+}
+
+TextureManager::DecodedTexture TextureManager::decodeTexture(std::stringstream& file, const std::string& source)
+{
+    DecodedTexture decoded;
 
     apng_data apng;
     if(load_apng(file, &apng) == 0) {
@@ -119,29 +221,30 @@ TexturePtr TextureManager::loadTexture(std::stringstream& file, const std::strin
             g_logger.warning(stdext::format("Texture %s has size %ix%i. Too keep highest performance you shouldn't use textures bigger than 512x512 (they can't be cached)", source, apng.width, apng.height));
         }
 #endif
+        decoded.size = imageSize;
         if(apng.num_frames > 1) { // animated texture
-            std::vector<ImagePtr> frames;
-            std::vector<int> framesDelay;
             for(uint i=0;i<apng.num_frames;++i) {
                 uchar *frameData = apng.pdata + ((apng.first_frame+i) * imageSize.area() * apng.bpp);
                 int frameDelay = apng.frames_delay[i];
 
-                framesDelay.push_back(frameDelay);
-                frames.push_back(ImagePtr(new Image(imageSize, apng.bpp, frameData)));
+                decoded.framesDelay.push_back(frameDelay);
+                decoded.frames.push_back(ImagePtr(new Image(imageSize, apng.bpp, frameData)));
             }
-            AnimatedTexturePtr animatedTexture = new AnimatedTexture(imageSize, frames, framesDelay);
-            m_animatedTextures.push_back(animatedTexture);
-            texture = animatedTexture;
         } else {
-            ImagePtr image = ImagePtr(new Image(imageSize, apng.bpp, apng.pdata));
-            if (!image) {
-                g_logger.error(stdext::format("Can't load texture: %s", source));
-            } else {
-                texture = TexturePtr(new Texture(image));
-            }
+            decoded.frames.push_back(ImagePtr(new Image(imageSize, apng.bpp, apng.pdata)));
         }
         free_apng(&apng);
     }
 
-    return texture;
+    return decoded;
+}
+
+TexturePtr TextureManager::createTexture(const DecodedTexture& decoded)
+{
+    if(decoded.frames.empty())
+        return nullptr;
+
+    if(decoded.frames.size() > 1)
+        return AnimatedTexturePtr(new AnimatedTexture(decoded.size, decoded.frames, decoded.framesDelay));
+    return TexturePtr(new Texture(decoded.frames[0]));
 }
@@ -36,13 +36,44 @@ public:
     void reload();
 
     void preload(const std::string& fileName) { getTexture(fileName); }
+    void preloadAsync(const std::string& fileName);
     TexturePtr getTexture(const std::string& fileName);
     TexturePtr loadTexture(std::stringstream& file, const std::string& source);
 
+    void setMemoryBudget(int megabytes);
+    int getMemoryBudget() { return m_memoryBudget / (1024 * 1024); }
+    uint64 getMemoryUsage() { return m_memoryUsage; }
+    int getTexturesCount() { return m_textures.size(); }
+    int getEvictedTexturesCount() { return m_evictedTextures; }
+
 private:
-    std::unordered_map<std::string, TexturePtr> m_textures;
-    std::vector<AnimatedTexturePtr> m_animatedTextures;
+    struct DecodedTexture {
+        Size size;
+        std::vector<ImagePtr> frames;
+        std::vector<int> framesDelay;
+    };
+
+    struct CachedTexture {
+        TexturePtr texture;
+        std::vector<std::string> names;
+        uint64 memory;
+        ticks_t lastUse;
+    };
+
+    static DecodedTexture decodeTexture(std::stringstream& file, const std::string& source);
+    static TexturePtr createTexture(const DecodedTexture& decoded);
+    void trimCache();
+    void releaseIdleAnimations();
+
+    // textures by resolved path, m_texturePaths maps every name a texture was requested with to that path
+    std::unordered_map<std::string, CachedTexture> m_textures;
+    std::unordered_map<std::string, std::string> m_texturePaths;
+    std::unordered_map<std::string, std::shared_future<DecodedTexture>> m_pendingTextures;
+    uint64 m_memoryUsage = 0;
+    uint64 m_memoryBudget = 256 * 1024 * 1024;
+    int m_evictedTextures = 0;
     ScheduledEventPtr m_liveReloadEvent;
+    ScheduledEventPtr m_releaseIdleEvent;
     std::list<uint> m_texturesToRelease;
 };
 
@@ -62,6 +62,21 @@
 
 #include <framework/util/extras.h>
 
+#ifdef FW_GRAPHICS
+// lua reads geometry right after adding children, whose layout update is deferred,
+// so the layouts placing the widget are applied first
+template<typename F>
+static void bindWidgetGeometryFunction(const std::string& functionName, F UIWidget::*function)
+{
+    LuaCppFunction bound = luabinder::bind_mem_fun<UIWidget>(function);
+    g_lua.registerClassMemberFunction<UIWidget>(functionName, [bound](LuaInterface* lua) -> int {
+        if(UIWidgetPtr widget = lua->castValue<UIWidgetPtr>(1))
+            g_ui.updateLayoutsOf(widget);
+        return bound(lua);
+    });
+}
+#endif
+
 void Application::registerLuaFunctions()
 {
     // conversion globals
@@ -257,6 +272,7 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "isLoadedFromArchive", &ResourceManager::isLoadedFromArchive, &g_resources);    
     g_lua.bindSingletonFunction("g_resources", "listUpdateableFiles", [] { return std::list<std::string>(); } );
     g_lua.bindSingletonFunction("g_resources", "fileChecksum", &ResourceManager::fileChecksum, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "fileChecksums", &ResourceManager::fileChecksums, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "filesChecksums", &ResourceManager::filesChecksums, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "selfChecksum", &ResourceManager::selfChecksum, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "updateData", &ResourceManager::updateData, &g_resources);
@@ -324,6 +340,12 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_app", "getGraphicsFps", &GraphicalApplication::getGraphicsFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "getProcessingFps", &GraphicalApplication::getProcessingFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "isOnInputEvent", &GraphicalApplication::isOnInputEvent, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setParallelMapPass", &GraphicalApplication::setParallelMapPass, &g_app);
+    g_lua.bindSingletonFunction("g_app", "isParallelMapPass", &GraphicalApplication::isParallelMapPass, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setMapFrameBufferReuse", &GraphicalApplication::setMapFrameBufferReuse, &g_app);
+    g_lua.bindSingletonFunction("g_app", "isMapFrameBufferReuse", &GraphicalApplication::isMapFrameBufferReuse, &g_app);
+    g_lua.bindSingletonFunction("g_app", "startBenchmark", &GraphicalApplication::startBenchmark, &g_app);
+    g_lua.bindSingletonFunction("g_app", "stopBenchmark", &GraphicalApplication::stopBenchmark, &g_app);
     g_lua.bindSingletonFunction("g_app", "doScreenshot", &GraphicalApplication::doScreenshot, &g_app);
     g_lua.bindSingletonFunction("g_app", "scaleDown", &GraphicalApplication::scaleDown, &g_app);
     g_lua.bindSingletonFunction("g_app", "scaleUp", &GraphicalApplication::scaleUp, &g_app);
@@ -336,6 +358,9 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_adaptiveRenderer", "getLevel", &AdaptiveRenderer::getLevel, &g_adaptiveRenderer);
     g_lua.bindSingletonFunction("g_adaptiveRenderer", "setLevel", &AdaptiveRenderer::setForcedLevel, &g_adaptiveRenderer);
     g_lua.bindSingletonFunction("g_adaptiveRenderer", "getDebugInfo", &AdaptiveRenderer::getDebugInfo, &g_adaptiveRenderer);
+    g_lua.bindSingletonFunction("g_adaptiveRenderer", "getTargetFrameTime", &AdaptiveRenderer::getTargetFrameTime, &g_adaptiveRenderer);
+    g_lua.bindSingletonFunction("g_adaptiveRenderer", "getPhaseLevels", &AdaptiveRenderer::getPhaseLevels, &g_adaptiveRenderer);
+    g_lua.bindSingletonFunction("g_adaptiveRenderer", "getPhaseCosts", &AdaptiveRenderer::getPhaseCosts, &g_adaptiveRenderer);
 
     // PlatformWindow
     g_lua.registerSingletonClass("g_window");
@@ -399,8 +424,14 @@ void Application::registerLuaFunctions()
     // Textures
     g_lua.registerSingletonClass("g_textures");
     g_lua.bindSingletonFunction("g_textures", "preload", &TextureManager::preload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "preloadAsync", &TextureManager::preloadAsync, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "clearCache", &TextureManager::clearCache, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "reload", &TextureManager::reload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setMemoryBudget", &TextureManager::setMemoryBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryBudget", &TextureManager::getMemoryBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryUsage", &TextureManager::getMemoryUsage, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getTexturesCount", &TextureManager::getTexturesCount, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getEvictedTexturesCount", &TextureManager::getEvictedTexturesCount, &g_textures);
 
     // Shaders
     g_lua.registerSingletonClass("g_shaders");
@@ -427,6 +458,9 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_ui", "isDrawingDebugBoxes", &UIManager::isDrawingDebugBoxes, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "isMouseGrabbed", &UIManager::isMouseGrabbed, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "isKeyboardGrabbed", &UIManager::isKeyboardGrabbed, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getLayoutUpdateCount", &UIManager::getLayoutUpdateCount, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getLayoutFlushCount", &UIManager::getLayoutFlushCount, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "resetLayoutCounters", &UIManager::resetLayoutCounters, &g_ui);
 
     // FontManager
     g_lua.registerSingletonClass("g_fonts");
@@ -498,9 +532,9 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("isChildLocked", &UIWidget::isChildLocked);
     g_lua.bindClassMemberFunction<UIWidget>("hasChild", &UIWidget::hasChild);
     g_lua.bindClassMemberFunction<UIWidget>("getChildIndex", &UIWidget::getChildIndex);
-    g_lua.bindClassMemberFunction<UIWidget>("getMarginRect", &UIWidget::getMarginRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getPaddingRect", &UIWidget::getPaddingRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildrenRect", &UIWidget::getChildrenRect);
+    bindWidgetGeometryFunction("getMarginRect", &UIWidget::getMarginRect);
+    bindWidgetGeometryFunction("getPaddingRect", &UIWidget::getPaddingRect);
+    bindWidgetGeometryFunction("getChildrenRect", &UIWidget::getChildrenRect);
     g_lua.bindClassMemberFunction<UIWidget>("getAnchoredLayout", &UIWidget::getAnchoredLayout);
     g_lua.bindClassMemberFunction<UIWidget>("getRootParent", &UIWidget::getRootParent);
     g_lua.bindClassMemberFunction<UIWidget>("getChildAfter", &UIWidget::getChildAfter);
@@ -546,7 +580,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("hasChildren", &UIWidget::hasChildren);
     g_lua.bindClassMemberFunction<UIWidget>("containsMarginPoint", &UIWidget::containsMarginPoint);
     g_lua.bindClassMemberFunction<UIWidget>("containsPaddingPoint", &UIWidget::containsPaddingPoint);
-    g_lua.bindClassMemberFunction<UIWidget>("containsPoint", &UIWidget::containsPoint);
+    bindWidgetGeometryFunction("containsPoint", &UIWidget::containsPoint);
     g_lua.bindClassMemberFunction<UIWidget>("getId", &UIWidget::getId);
     g_lua.bindClassMemberFunction<UIWidget>("getSource", &UIWidget::getSource);
     g_lua.bindClassMemberFunction<UIWidget>("getParent", &UIWidget::getParent);
@@ -615,13 +649,13 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("setPaddingLeft", &UIWidget::setPaddingLeft);
     g_lua.bindClassMemberFunction<UIWidget>("setOpacity", &UIWidget::setOpacity);
     g_lua.bindClassMemberFunction<UIWidget>("setRotation", &UIWidget::setRotation);
-    g_lua.bindClassMemberFunction<UIWidget>("getX", &UIWidget::getX);
-    g_lua.bindClassMemberFunction<UIWidget>("getY", &UIWidget::getY);
-    g_lua.bindClassMemberFunction<UIWidget>("getPosition", &UIWidget::getPosition);
-    g_lua.bindClassMemberFunction<UIWidget>("getWidth", &UIWidget::getWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getHeight", &UIWidget::getHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("getSize", &UIWidget::getSize);
-    g_lua.bindClassMemberFunction<UIWidget>("getRect", &UIWidget::getRect);
+    bindWidgetGeometryFunction("getX", &UIWidget::getX);
+    bindWidgetGeometryFunction("getY", &UIWidget::getY);
+    bindWidgetGeometryFunction("getPosition", &UIWidget::getPosition);
+    bindWidgetGeometryFunction("getWidth", &UIWidget::getWidth);
+    bindWidgetGeometryFunction("getHeight", &UIWidget::getHeight);
+    bindWidgetGeometryFunction("getSize", &UIWidget::getSize);
+    bindWidgetGeometryFunction("getRect", &UIWidget::getRect);
     g_lua.bindClassMemberFunction<UIWidget>("getColor", &UIWidget::getColor);
     g_lua.bindClassMemberFunction<UIWidget>("getBackgroundColor", &UIWidget::getBackgroundColor);
     g_lua.bindClassMemberFunction<UIWidget>("getBackgroundOffsetX", &UIWidget::getBackgroundOffsetX);
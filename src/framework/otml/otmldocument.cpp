@@ -35,27 +35,36 @@ OTMLDocumentPtr OTMLDocument::create()
 
 OTMLDocumentPtr OTMLDocument::parse(const std::string& fileName)
 {
-    std::stringstream fin;
     std::string source = g_resources.resolvePath(fileName);
-    g_resources.readFileStream(source, fin);
-    return parse(fin, source);
+    std::string data = g_resources.readFileContents(source);
+    if(data.empty()) {
+        OTMLDocumentPtr doc(new OTMLDocument);
+        doc->setSource(source);
+        throw OTMLException(doc, "cannot read from input stream");
+    }
+    return parseString(data, source);
 }
 
 OTMLDocumentPtr OTMLDocument::parseString(const std::string& data, const std::string& source)
-{
-    std::istringstream is(data);
-    return parse(is, source);
-}
-
-OTMLDocumentPtr OTMLDocument::parse(std::istream& in, const std::string& source)
 {
     OTMLDocumentPtr doc(new OTMLDocument);
     doc->setSource(source);
-    OTMLParser parser(doc, in);
+    OTMLParser parser(doc, data);
     parser.parse();
     return doc;
 }
 
+OTMLDocumentPtr OTMLDocument::parse(std::istream& in, const std::string& source)
+{
+    if(!in.good()) {
+        OTMLDocumentPtr doc(new OTMLDocument);
+        doc->setSource(source);
+        throw OTMLException(doc, "cannot read from input stream");
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return parseString(data, source);
+}
+
 std::string OTMLDocument::emit()
 {
     return OTMLEmitter::emitNode(asOTMLNode()) + "\n";
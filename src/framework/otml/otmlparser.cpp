@@ -25,35 +25,54 @@
 #include "otmlexception.h"
 #include <boost/tokenizer.hpp>
 
-OTMLParser::OTMLParser(OTMLDocumentPtr doc, std::istream& in) :
+namespace {
+
+std::string_view trimmed(std::string_view str)
+{
+    while(!str.empty() && std::isspace((uchar)str.front()))
+        str.remove_prefix(1);
+    while(!str.empty() && std::isspace((uchar)str.back()))
+        str.remove_suffix(1);
+    return str;
+}
+
+}
+
+OTMLParser::OTMLParser(OTMLDocumentPtr doc, const std::string& data) :
     currentDepth(0), currentLine(0),
-    doc(doc), currentParent(doc), previousNode(0),
-    in(in)
+    doc(doc), sourcePrefix(doc->source() + ":"), currentParent(doc), previousNode(0),
+    data(data), pos(0), eof(false)
 {
+    parents.push_back(currentParent);
 }
 
 void OTMLParser::parse()
 {
-    if(!in.good())
-        throw OTMLException(doc, "cannot read from input stream");
-
-    while(!in.eof())
+    while(!eof)
         parseLine(getNextLine());
 }
 
-std::string OTMLParser::getNextLine()
+std::string_view OTMLParser::getNextLine()
 {
     currentLine++;
-    std::string line;
-    std::getline(in, line);
+    std::size_t end = data.find('\n', pos);
+    std::string_view line;
+    if(end == std::string_view::npos) {
+        line = data.substr(pos);
+        pos = data.size();
+        eof = true;
+    } else {
+        line = data.substr(pos, end - pos);
+        pos = end + 1;
+    }
     return line;
 }
 
-int OTMLParser::getLineDepth(const std::string& line, bool multilining)
+int OTMLParser::getLineDepth(std::string_view line, bool multilining)
 {
     // count number of spaces at the line beginning
     std::size_t spaces = 0;
-    while(line[spaces] == ' ')
+    while(spaces < line.size() && line[spaces] == ' ')
         spaces++;
 
     // pre calculate depth
@@ -61,7 +80,7 @@ int OTMLParser::getLineDepth(const std::string& line, bool multilining)
 
     if(!multilining || depth <= currentDepth) {
         // check the next character is a tab
-        if(line[spaces] == '\t')
+        if(spaces < line.size() && line[spaces] == '\t')
             throw OTMLException(doc, "indentation with tabs are not allowed", currentLine);
 
         // must indent every 2 spaces
@@ -72,7 +91,7 @@ int OTMLParser::getLineDepth(const std::string& line, bool multilining)
     return depth;
 }
 
-void OTMLParser::parseLine(std::string line)
+void OTMLParser::parseLine(std::string_view line)
 {
     int depth = getLineDepth(line);
 
@@ -80,23 +99,24 @@ void OTMLParser::parseLine(std::string line)
         return;
 
     // remove line sides spaces
-    stdext::trim(line);
+    line = trimmed(line);
 
     // skip empty lines
     if(line.empty())
         return;
 
     // skip comments
-    if(stdext::starts_with(line, "//"))
+    if(line.compare(0, 2, "//") == 0)
         return;
 
     // a depth above, change current parent to the previous added node
-    if(depth == currentDepth+1) {
+    if(depth == currentDepth+1 && previousNode) {
         currentParent = previousNode;
+        parents.push_back(currentParent);
     // a depth below, change parent to previous parent
     } else if(depth < currentDepth) {
-        for(int i=0;i<currentDepth-depth;++i)
-            currentParent = parentMap[currentParent];
+        parents.resize(depth+1);
+        currentParent = parents.back();
     // if it isn't the current depth, it's a syntax error
     } else if(depth != currentDepth)
         throw OTMLException(doc, "invalid indentation depth, are you indenting correctly?", currentLine);
@@ -109,37 +129,36 @@ void OTMLParser::parseLine(std::string line)
     parseNode(line);
 }
 
-void OTMLParser::parseNode(const std::string& data)
+void OTMLParser::parseNode(std::string_view data)
 {
-    std::string tag;
-    std::string value;
+    std::string_view tag;
+    std::string_view value;
     std::size_t dotsPos = data.find_first_of(':');
     int nodeLine = currentLine;
 
     // node that has no tag and may have a value
     if(!data.empty() && data[0] == '-') {
         value = data.substr(1);
-        stdext::trim(value);
     // node that has tag and possible a value
-    } else if(dotsPos != std::string::npos) {
+    } else if(dotsPos != std::string_view::npos) {
         tag = data.substr(0, dotsPos);
-        if(data.size() > dotsPos+1)
-            value = data.substr(dotsPos+1);
+        value = data.substr(dotsPos+1);
     // node that has only a tag
     } else {
         tag = data;
     }
 
-    stdext::trim(tag);
-    stdext::trim(value);
+    tag = trimmed(tag);
+    value = trimmed(value);
 
     // process multitine values
-    if(value == "|" || value == "|-" || value == "|+") {
+    std::string multiLineData;
+    bool multiLine = (value == "|" || value == "|-" || value == "|+");
+    if(multiLine) {
         // reads next lines until we can a value below the same depth
-        std::string multiLineData;
         do {
-            size_t lastPos = in.tellg();
-            std::string line = getNextLine();
+            std::size_t lastPos = pos;
+            std::string_view line = getNextLine();
             int depth = getLineDepth(line, true);
 
             // depth above current depth, add the text to the multiline
@@ -148,16 +167,16 @@ void OTMLParser::parseNode(const std::string& data)
             // it has contents below the current depth
             } else {
                 // if not empty, its a node
-                stdext::trim(line);
-                if(!line.empty()) {
+                if(!trimmed(line).empty()) {
                     // rewind and break
-                    in.seekg(lastPos, std::ios::beg);
+                    pos = lastPos;
+                    eof = false;
                     currentLine--;
                     break;
                 }
             }
             multiLineData += "\n";
-        } while(!in.eof());
+        } while(!eof);
 
         /* determine how to treat new lines at the end
          * | strip all new lines at the end and add just a new one
@@ -166,9 +185,8 @@ void OTMLParser::parseNode(const std::string& data)
          */
         if(value == "|" || value == "|-") {
             // remove all new lines at the end
-            int lastPos = multiLineData.length();
-            while(multiLineData[--lastPos] == '\n')
-                multiLineData.erase(lastPos, 1);
+            while(!multiLineData.empty() && multiLineData.back() == '\n')
+                multiLineData.pop_back();
 
             if(value == "|")
                 multiLineData.append("\n");
@@ -178,28 +196,26 @@ void OTMLParser::parseNode(const std::string& data)
     }
 
     // create the node
-    OTMLNodePtr node = OTMLNode::create(tag);
+    OTMLNodePtr node = OTMLNode::create(std::string(tag));
 
-    node->setUnique(dotsPos != std::string::npos);
-    node->setTag(tag);
-    node->setSource(doc->source() + ":" + stdext::unsafe_cast<std::string>(nodeLine));
+    node->setUnique(dotsPos != std::string_view::npos);
+    node->setSource(sourcePrefix + std::to_string(nodeLine));
 
     // ~ is considered the null value
     if(value == "~")
         node->setNull(true);
     else {
-        if(stdext::starts_with(value, "[") && stdext::ends_with(value, "]")) {
-            std::string tmp = value.substr(1, value.length()-2);
+        if(value.size() >= 2 && value.front() == '[' && value.back() == ']') {
+            std::string tmp(value.substr(1, value.length()-2));
             boost::tokenizer<boost::escaped_list_separator<char>> tokens(tmp);
             for(std::string v : tokens) {
                 stdext::trim(v);
                 node->writeIn(v);
             }
         } else
-            node->setValue(value);
+            node->setValue(std::string(value));
     }
 
     currentParent->addChild(node);
-    parentMap[node] = currentParent;
     previousNode = node;
 }
@@ -25,32 +25,37 @@
 
 #include "declarations.h"
 
+#include <string_view>
+
 class OTMLParser
 {
 public:
-    OTMLParser(OTMLDocumentPtr doc, std::istream& in);
+    OTMLParser(OTMLDocumentPtr doc, const std::string& data);
 
     /// Parse the entire document
     void parse();
 
 private:
-    /// Retrieve next line from the input stream
-    std::string getNextLine();
+    /// Retrieve next line from the buffer, without copying it
+    std::string_view getNextLine();
     /// Counts depth of a line (every 2 spaces increments one depth)
-    int getLineDepth(const std::string& line, bool multilining = false);
+    int getLineDepth(std::string_view line, bool multilining = false);
 
-    /// Parse each line of the input stream
-    void parseLine(std::string line);
+    /// Parse each line of the buffer
+    void parseLine(std::string_view line);
     /// Parse nodes tag and value
-    void parseNode(const std::string& data);
+    void parseNode(std::string_view data);
 
     int currentDepth;
     int currentLine;
     OTMLDocumentPtr doc;
+    std::string sourcePrefix;
     OTMLNodePtr currentParent;
-    std::unordered_map<OTMLNodePtr, OTMLNodePtr> parentMap;
+    std::vector<OTMLNodePtr> parents;
     OTMLNodePtr previousNode;
-    std::istream& in;
+    std::string_view data;
+    std::size_t pos;
+    bool eof;
 };
 
 #endif
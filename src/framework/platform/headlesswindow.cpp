@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2010-2016 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef HEADLESS_WINDOW
+
+#include "headlesswindow.h"
+#include <framework/core/eventdispatcher.h>
+
+#include <EGL/eglext.h>
+
+HeadlessWindow::HeadlessWindow()
+{
+    m_eglDisplay = EGL_NO_DISPLAY;
+    m_eglConfig = 0;
+    m_eglContext = EGL_NO_CONTEXT;
+    m_eglSurface = EGL_NO_SURFACE;
+    m_minimumSize = Size(600,480);
+    m_size = Size(800,600);
+}
+
+void HeadlessWindow::init()
+{
+    // prefer the surfaceless platform, it doesn't need any display server or device
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if(clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(getPlatformDisplay)
+            m_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if(m_eglDisplay == EGL_NO_DISPLAY)
+        m_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(m_eglDisplay == EGL_NO_DISPLAY)
+        g_logger.fatal("EGL not supported");
+    if(!eglInitialize(m_eglDisplay, NULL, NULL))
+        g_logger.fatal("Unable to initialize EGL");
+
+    internalCreateGLContext();
+    internalCreateSurface();
+    m_focused = true;
+}
+
+void HeadlessWindow::terminate()
+{
+    internalDestroyGLContext();
+    m_visible = false;
+}
+
+void HeadlessWindow::internalCreateGLContext()
+{
+#ifdef OPENGL_ES
+    if(!eglBindAPI(EGL_OPENGL_ES_API))
+        g_logger.fatal("Unable to bind OpenGL ES API");
+#else
+    if(!eglBindAPI(EGL_OPENGL_API))
+        g_logger.fatal("Unable to bind OpenGL API");
+#endif
+
+    static int attrList[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+#ifdef OPENGL_ES
+#if OPENGL_ES==2
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+#else
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT,
+#endif
+#else
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+#endif
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLint numConfig;
+    if(!eglChooseConfig(m_eglDisplay, attrList, &m_eglConfig, 1, &numConfig) || numConfig == 0)
+        g_logger.fatal("Failed to choose EGL config");
+
+    EGLint contextAttrList[] = {
+#ifdef OPENGL_ES
+#if OPENGL_ES==2
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+#else
+        EGL_CONTEXT_CLIENT_VERSION, 1,
+#endif
+#endif
+        EGL_NONE
+    };
+
+    m_eglContext = eglCreateContext(m_eglDisplay, m_eglConfig, EGL_NO_CONTEXT, contextAttrList);
+    if(m_eglContext == EGL_NO_CONTEXT)
+        g_logger.fatal(stdext::format("Unable to create EGL context: %i", eglGetError()));
+}
+
+void HeadlessWindow::internalCreateSurface()
+{
+    // the pbuffer has a fixed size, resizing creates a new one
+    eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(m_eglSurface != EGL_NO_SURFACE)
+        eglDestroySurface(m_eglDisplay, m_eglSurface);
+
+    EGLint surfaceAttrList[] = {
+        EGL_WIDTH, m_size.width(),
+        EGL_HEIGHT, m_size.height(),
+        EGL_NONE
+    };
+    m_eglSurface = eglCreatePbufferSurface(m_eglDisplay, m_eglConfig, surfaceAttrList);
+    if(m_eglSurface == EGL_NO_SURFACE)
+        g_logger.fatal(stdext::format("Unable to create EGL pbuffer surface: %i", eglGetError()));
+    if(!eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext))
+        g_logger.fatal("Unable to connect EGL context into pbuffer surface");
+}
+
+void HeadlessWindow::internalDestroyGLContext()
+{
+    if(m_eglDisplay == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(m_eglContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_eglDisplay, m_eglContext);
+        m_eglContext = EGL_NO_CONTEXT;
+    }
+    if(m_eglSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_eglDisplay, m_eglSurface);
+        m_eglSurface = EGL_NO_SURFACE;
+    }
+    eglTerminate(m_eglDisplay);
+    m_eglDisplay = EGL_NO_DISPLAY;
+}
+
+void HeadlessWindow::move(const Point& pos)
+{
+    m_position = pos;
+}
+
+void HeadlessWindow::resize(const Size& size)
+{
+    if (std::this_thread::get_id() != g_mainThreadId) {
+        g_graphicsDispatcher.addEvent(std::bind(&HeadlessWindow::resize, this, size));
+        return;
+    }
+
+    if(size.width() < m_minimumSize.width() || size.height() < m_minimumSize.height() || size == m_size)
+        return;
+    m_size = size;
+    internalCreateSurface();
+    if(m_onResize)
+        m_onResize(m_size);
+}
+
+void HeadlessWindow::show()
+{
+    if (std::this_thread::get_id() != g_mainThreadId) {
+        g_graphicsDispatcher.addEvent(std::bind(&HeadlessWindow::show, this));
+        return;
+    }
+
+    if(m_visible)
+        return;
+    m_visible = true;
+    if(m_onResize)
+        m_onResize(m_size);
+}
+
+void HeadlessWindow::hide()
+{
+    m_visible = false;
+}
+
+void HeadlessWindow::minimize()
+{
+}
+
+void HeadlessWindow::maximize()
+{
+    m_maximized = true;
+}
+
+void HeadlessWindow::poll()
+{
+    // there are no input events
+}
+
+void HeadlessWindow::swapBuffers()
+{
+    eglSwapBuffers(m_eglDisplay, m_eglSurface);
+}
+
+void HeadlessWindow::setVerticalSync(bool enable)
+{
+    if (std::this_thread::get_id() != g_mainThreadId) {
+        g_graphicsDispatcher.addEvent(std::bind(&HeadlessWindow::setVerticalSync, this, enable));
+        return;
+    }
+    eglSwapInterval(m_eglDisplay, enable ? 1 : 0);
+    m_verticalSync = enable;
+}
+
+void HeadlessWindow::displayFatalError(const std::string& message)
+{
+    // nobody can see a message box, the logger already printed it
+}
+
+#endif
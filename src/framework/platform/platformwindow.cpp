@@ -34,6 +34,23 @@ SDLWindow window;
 #include "x11window.h"
 #include <framework/core/clock.h>
 X11Window window;
+#ifdef HEADLESS_WINDOW
+#include "headlesswindow.h"
+#include <fstream>
+HeadlessWindow headlessWindow;
+
+// g_window is bound before main runs, so the command line is read from procfs
+static bool isHeadless()
+{
+    std::ifstream cmdline("/proc/self/cmdline", std::ios::binary);
+    std::string arg;
+    while(std::getline(cmdline, arg, '\0')) {
+        if(arg == "--headless")
+            return true;
+    }
+    return false;
+}
+#endif
 #endif
 
 #include <framework/core/clock.h>
@@ -42,6 +59,8 @@ X11Window window;
 
 #ifdef ANDROID
 PlatformWindow& g_window = g_androidWindow;
+#elif defined(HEADLESS_WINDOW) && !defined(WIN32) && !defined(__EMSCRIPTEN__)
+PlatformWindow& g_window = isHeadless() ? static_cast<PlatformWindow&>(headlessWindow) : window;
 #else
 PlatformWindow& g_window = window;
 #endif
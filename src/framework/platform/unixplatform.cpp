@@ -177,7 +177,12 @@ double Platform::getTotalSystemMemory()
 
 double Platform::getMemoryUsage()
 {
-    return 0;
+    // resident set size, second field of statm in pages, 0 where there is no procfs
+    std::ifstream in("/proc/self/statm");
+    double size = 0, resident = 0;
+    if(!(in >> size >> resident))
+        return 0;
+    return resident * sysconf(_SC_PAGESIZE);
 }
 
 std::string Platform::getOSName()
@@ -47,17 +47,17 @@ uint32_t adler32(const uint8_t *buffer, size_t size) {
 
 long random_range(long min, long max)
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<long> dis(0, 2147483647);
+    static thread_local std::random_device rd;
+    static thread_local std::mt19937 gen(rd());
+    static thread_local std::uniform_int_distribution<long> dis(0, 2147483647);
     return min + (dis(gen) % (max - min + 1));
 }
 
 float random_range(float min, float max)
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> dis(0.0, 1.0);
+    static thread_local std::random_device rd;
+    static thread_local std::mt19937 gen(rd());
+    static thread_local std::uniform_real_distribution<float> dis(0.0, 1.0);
     return min + (max - min)*dis(gen);
 }
 
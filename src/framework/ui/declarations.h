@@ -36,6 +36,7 @@ class UIGridLayout;
 class UIAnchor;
 class UIAnchorGroup;
 class UIAnchorLayout;
+struct UIStateStyles;
 
 typedef stdext::shared_object_ptr<UIWidget> UIWidgetPtr;
 typedef stdext::shared_object_ptr<UITextEdit> UITextEditPtr;
@@ -47,6 +48,7 @@ typedef stdext::shared_object_ptr<UIGridLayout> UIGridLayoutPtr;
 typedef stdext::shared_object_ptr<UIAnchor> UIAnchorPtr;
 typedef stdext::shared_object_ptr<UIAnchorGroup> UIAnchorGroupPtr;
 typedef stdext::shared_object_ptr<UIAnchorLayout> UIAnchorLayoutPtr;
+typedef std::shared_ptr<UIStateStyles> UIStateStylesPtr;
 
 typedef std::deque<UIWidgetPtr> UIWidgetList;
 typedef std::vector<UIAnchorPtr> UIAnchorList;
@@ -32,8 +32,8 @@ public:
     UIBoxLayout(UIWidgetPtr parentWidget);
 
     void applyStyle(const OTMLNodePtr& styleNode);
-    void addWidget(const UIWidgetPtr& widget) { update(); }
-    void removeWidget(const UIWidgetPtr& widget) { update(); }
+    void addWidget(const UIWidgetPtr& widget) { updateLater(); }
+    void removeWidget(const UIWidgetPtr& widget) { updateLater(); }
 
     void setSpacing(int spacing) { m_spacing = spacing; update(); }
     void setFitChildren(bool fitParent) { m_fitChildren = fitParent; update(); }
@@ -61,12 +61,12 @@ void UIGridLayout::applyStyle(const OTMLNodePtr& styleNode)
 
 void UIGridLayout::removeWidget(const UIWidgetPtr& widget)
 {
-    update();
+    updateLater();
 }
 
 void UIGridLayout::addWidget(const UIWidgetPtr& widget)
 {
-    update();
+    updateLater();
 }
 
 bool UIGridLayout::internalUpdate()
@@ -22,8 +22,7 @@
 
 #include "uilayout.h"
 #include "uiwidget.h"
-
-#include <framework/core/eventdispatcher.h>
+#include "uimanager.h"
 
 void UILayout::update()
 {
@@ -50,6 +49,7 @@ void UILayout::update()
     }
 
     m_updating = true;
+    g_ui.m_layoutUpdateCount++;
     internalUpdate();
     m_parentWidget->onLayoutUpdate();
     m_updating = false;
@@ -63,10 +63,7 @@ void UILayout::updateLater()
     if(!getParentWidget())
         return;
 
-    auto self = static_self_cast<UILayout>();
-    g_dispatcher.addEvent([self] {
-        self->m_updateScheduled = false;
-        self->update();
-    });
+    // layouts are updated together once per frame, see UIManager::updatePendingLayouts
+    g_ui.scheduleLayoutUpdate(static_self_cast<UILayout>());
     m_updateScheduled = true;
 }
@@ -57,6 +57,8 @@ public:
 protected:
     virtual bool internalUpdate() { return false; }
 
+    friend class UIManager;
+
     int m_updateDisabled;
     stdext::boolean<false> m_updating;
     stdext::boolean<false> m_updateScheduled;
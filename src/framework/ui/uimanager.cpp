@@ -54,6 +54,8 @@ void UIManager::terminate()
     for(auto& widget : m_pressedWidget)
         widget = nullptr;
     m_styles.clear();
+    m_documents.clear();
+    m_pendingLayouts.clear();
     m_destroyedWidgets.clear();
     m_checkEvent = nullptr;
 }
@@ -334,9 +336,102 @@ void UIManager::onWidgetDestroy(const UIWidgetPtr& widget)
     }, 1000);
 }
 
+void UIManager::scheduleLayoutUpdate(const UILayoutPtr& layout)
+{
+    m_pendingLayouts.push_back(layout);
+    if(m_layoutUpdateScheduled)
+        return;
+
+    m_layoutUpdateScheduled = true;
+    g_dispatcher.addEvent([this] {
+        m_layoutUpdateScheduled = false;
+        updatePendingLayouts();
+    });
+}
+
+void UIManager::updatePendingLayouts()
+{
+    // layouts scheduled while updating are handled in the next round,
+    // the cap avoids looping forever on layouts that never settle
+    const int maxRounds = 10;
+    for(int round = 0; round < maxRounds && !m_pendingLayouts.empty(); ++round) {
+        std::vector<std::pair<int, UILayoutPtr>> layouts;
+        layouts.reserve(m_pendingLayouts.size());
+        for(const UILayoutPtr& layout : m_pendingLayouts) {
+            int depth = 0;
+            for(UIWidgetPtr widget = layout->getParentWidget(); widget; widget = widget->getParent())
+                depth++;
+            layouts.push_back(std::make_pair(depth, layout));
+        }
+        m_pendingLayouts.clear();
+
+        // parents first, so children are laid out with their final size only once
+        std::stable_sort(layouts.begin(), layouts.end(), [](const std::pair<int, UILayoutPtr>& a, const std::pair<int, UILayoutPtr>& b) {
+            return a.first < b.first;
+        });
+
+        for(auto& it : layouts) {
+            // already applied by updateLayoutsOf, or listed twice after being scheduled again
+            if(!it.second->m_updateScheduled)
+                continue;
+            it.second->m_updateScheduled = false;
+            it.second->update();
+        }
+        m_layoutFlushCount++;
+    }
+
+    // leftovers go to the next frame
+    if(!m_pendingLayouts.empty() && !m_layoutUpdateScheduled) {
+        m_layoutUpdateScheduled = true;
+        g_dispatcher.scheduleEvent([this] {
+            m_layoutUpdateScheduled = false;
+            updatePendingLayouts();
+        }, 0);
+    }
+}
+
+void UIManager::updateLayoutsOf(const UIWidgetPtr& widget)
+{
+    if(m_pendingLayouts.empty())
+        return;
+
+    // the widget is placed by the layouts of its ancestors and sized by its own, updating them
+    // can schedule the layouts above again (fit children), so repeat until the chain is settled
+    const int maxRounds = 10;
+    for(int round = 0; round < maxRounds; ++round) {
+        std::vector<UILayoutPtr> layouts;
+        for(UIWidgetPtr parent = widget; parent; parent = parent->getParent()) {
+            UILayoutPtr layout = parent->getLayout();
+            if(layout && layout->m_updateScheduled)
+                layouts.push_back(layout);
+        }
+        if(layouts.empty())
+            return;
+
+        // outermost first, they stay in m_pendingLayouts and are skipped there
+        for(auto it = layouts.rbegin(); it != layouts.rend(); ++it) {
+            (*it)->m_updateScheduled = false;
+            (*it)->update();
+        }
+        m_layoutFlushCount++;
+    }
+}
+
 void UIManager::clearStyles()
 {
     m_styles.clear();
+    m_stateStyles.clear();
+}
+
+UIStateStylesPtr UIManager::getStateStyles(const OTMLNodePtr& style)
+{
+    auto& entry = m_stateStyles[style.get()];
+    if(!entry.second) {
+        entry.first = style;
+        entry.second = std::make_shared<UIStateStyles>();
+        entry.second->compile(style);
+    }
+    return entry.second;
 }
 
 bool UIManager::importStyle(std::string file)
@@ -344,7 +439,7 @@ bool UIManager::importStyle(std::string file)
     try {
         file = g_resources.guessFilePath(file, "otui");
 
-        OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        OTMLDocumentPtr doc = loadDocument(file);
 
         for(const OTMLNodePtr& styleNode : doc->children())
             importStyleFromOTML(styleNode);
@@ -385,9 +480,6 @@ void UIManager::importStyleFromOTML(const OTMLNodePtr& styleNode)
     if(name[0] == '#') {
         name = name.substr(1);
         unique = true;
-
-        styleNode->setTag(name);
-        styleNode->writeAt("__unique", true);
     }
 
     OTMLNodePtr oldStyle = m_styles[name];
@@ -408,6 +500,11 @@ void UIManager::importStyleFromOTML(const OTMLNodePtr& styleNode)
         OTMLNodePtr style = originalStyle->clone();
         style->merge(styleNode);
         style->setTag(name);
+        // styleNode may belong to a cached document, only the copy is changed
+        if(unique)
+            style->writeAt("__unique", true);
+        if(oldStyle)
+            m_stateStyles.erase(oldStyle.get());
         m_styles[name] = style;
     }
 }
@@ -472,7 +569,7 @@ UIWidgetPtr UIManager::loadUI(std::string file, const UIWidgetPtr& parent)
     try {
         file = g_resources.guessFilePath(file, "otui");
 
-        OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        OTMLDocumentPtr doc = loadDocument(file);
         UIWidgetPtr widget;
         for(const OTMLNodePtr& node : doc->children()) {
             std::string tag = node->tag();
@@ -494,6 +591,24 @@ UIWidgetPtr UIManager::loadUI(std::string file, const UIWidgetPtr& parent)
     }
 }
 
+OTMLDocumentPtr UIManager::loadDocument(const std::string& file)
+{
+    std::string source = g_resources.resolvePath(file);
+
+    int64 size, modTime;
+    if(!g_resources.getFileStat(source, size, modTime))
+        return OTMLDocument::parse(source);
+
+    // documents are only read from, widgets and styles are created from clones of their nodes
+    auto it = m_documents.find(source);
+    if(it != m_documents.end() && it->second.size == size && it->second.modTime == modTime)
+        return it->second.doc;
+
+    OTMLDocumentPtr doc = OTMLDocument::parse(source);
+    m_documents[source] = CachedDocument{doc, size, modTime};
+    return doc;
+}
+
 UIWidgetPtr UIManager::createWidget(const std::string& styleName, const UIWidgetPtr& parent)
 {
     OTMLNodePtr node = OTMLNode::create(styleName);
@@ -524,7 +639,15 @@ UIWidgetPtr UIManager::createWidgetFromOTML(const OTMLNodePtr& widgetNode, const
     if(widget) {
         widget->callLuaField("onCreate");
 
-        widget->setStyleFromNode(styleNode);
+        // the state selectors are the registered style's unless the widget node adds its own
+        OTMLNodePtr origin = originalStyleNode;
+        for(const OTMLNodePtr& node : widgetNode->children()) {
+            if(stdext::starts_with(node->tag(), "$")) {
+                origin = nullptr;
+                break;
+            }
+        }
+        widget->setStyleNode(styleNode, origin);
 
         for(const OTMLNodePtr& childNode : styleNode->children()) {
             if(!childNode->isUnique()) {
@@ -42,12 +42,18 @@ public:
     void updatePressedWidget(const Fw::MouseButton button, const UIWidgetPtr& newPressedWidget, const Point& clickedPos = Point(), bool fireClicks = true);
     bool updateDraggingWidget(const UIWidgetPtr& draggingWidget, const Point& clickedPos = Point());
     void updateHoveredWidget(bool now = false);
+    void scheduleLayoutUpdate(const UILayoutPtr& layout);
+    void updatePendingLayouts();
+    // applies the pending layouts that place or size the widget, so its geometry can be read right away
+    void updateLayoutsOf(const UIWidgetPtr& widget);
 
     void clearStyles();
     bool importStyle(std::string file);
     bool importStyleFromString(std::string data);
     void importStyleFromOTML(const OTMLNodePtr& styleNode);
     OTMLNodePtr getStyle(const std::string& styleName);
+    // compiled state selectors of a registered style, compiled on first use
+    UIStateStylesPtr getStateStyles(const OTMLNodePtr& style);
     std::string getStyleClass(const std::string& styleName);
 
     UIWidgetPtr loadUIFromString(const std::string& data, const UIWidgetPtr& parent);
@@ -72,14 +78,28 @@ public:
 
     bool isDrawingDebugBoxes() { return m_drawDebugBoxes; }
 
+    int getLayoutUpdateCount() { return m_layoutUpdateCount; }
+    int getLayoutFlushCount() { return m_layoutFlushCount; }
+    void resetLayoutCounters() { m_layoutUpdateCount = 0; m_layoutFlushCount = 0; }
+
 protected:
     void onWidgetAppear(const UIWidgetPtr& widget);
     void onWidgetDisappear(const UIWidgetPtr& widget);
     void onWidgetDestroy(const UIWidgetPtr& widget);
 
+    OTMLDocumentPtr loadDocument(const std::string& file);
+
     friend class UIWidget;
+    friend class UILayout;
 
 private:
+    // parsed otui files, reused while the file size and modification time don't change
+    struct CachedDocument {
+        OTMLDocumentPtr doc;
+        int64 size;
+        int64 modTime;
+    };
+
     UIWidgetPtr m_rootWidget;
     UIWidgetPtr m_mouseReceiver;
     UIWidgetPtr m_keyboardReceiver;
@@ -87,8 +107,15 @@ private:
     UIWidgetPtr m_hoveredWidget;
     UIWidgetPtr m_pressedWidget[Fw::MouseButtonLast + 1] = { nullptr };
     stdext::boolean<false> m_hoverUpdateScheduled;
+    stdext::boolean<false> m_layoutUpdateScheduled;
+    std::vector<UILayoutPtr> m_pendingLayouts;
+    int m_layoutUpdateCount = 0;
+    int m_layoutFlushCount = 0;
     stdext::boolean<false> m_drawDebugBoxes;
     std::unordered_map<std::string, OTMLNodePtr> m_styles;
+    // holds the style node too, so its address can't be reused by another while cached
+    std::unordered_map<OTMLNode*, std::pair<OTMLNodePtr, UIStateStylesPtr>> m_stateStyles;
+    std::unordered_map<std::string, CachedDocument> m_documents;
     UIWidgetList m_destroyedWidgets;
     ScheduledEventPtr m_checkEvent;
     stdext::timer m_moveTimer;
@@ -58,6 +58,9 @@ UITextEdit::UITextEdit()
     m_selectionColor = Color::white;
     m_selectionBackgroundColor = Color::black;
     m_glyphsMustRecache = true;
+    m_maxLineWidth = 0;
+    m_visibleGlyphStart = 0;
+    m_visibleGlyphEnd = 0;
     m_placeholder = "";
     m_placeholderColor = Color::gray;
     m_placeholderFont = g_fonts.getDefaultFont();
@@ -93,7 +96,7 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
     if(m_color != Color::alpha) {
         if(glyphsMustRecache) {
             m_glyphsTextCoordsBuffer.clear();
-            for (int i = 0; i < textLength; ++i) {
+            for (int i = m_visibleGlyphStart, end = std::min<int>(m_visibleGlyphEnd, textLength); i < end; ++i) {
                 if(m_glyphsCoords[i].isValid())
                     m_glyphsTextCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
             }
@@ -112,8 +115,12 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
     if(hasSelection()) {
         if(glyphsMustRecache) {
             m_glyphsSelectCoordsBuffer.clear();
-            for(int i=m_selectionStart;i<m_selectionEnd;++i)
-                m_glyphsSelectCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
+            int start = std::max<int>(m_selectionStart, m_visibleGlyphStart);
+            int end = std::min<int>(std::min<int>(m_selectionEnd, m_visibleGlyphEnd), textLength);
+            for(int i = start; i < end; ++i) {
+                if(m_glyphsCoords[i].isValid())
+                    m_glyphsSelectCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
+            }
         }
         g_drawQueue->addFillCoords(m_glyphsSelectCoordsBuffer, m_selectionBackgroundColor);
         g_drawQueue->addTextureCoords(m_glyphsSelectCoordsBuffer, texture, m_selectionColor);
@@ -159,13 +166,18 @@ void UITextEdit::update(bool focusCursor)
     // recache coords buffers
     recacheGlyphs();
 
-    // map glyphs positions
-    Size textBoxSize;
-    const std::vector<Point>& glyphsPositions = m_font->calculateGlyphsPositions(text, m_textAlign, &textBoxSize);
+    // map glyphs positions, only the edited lines are laid out again
+    updateTextLayout(text);
+
     const Rect *glyphsTextureCoords = m_font->getGlyphsTextureCoords();
     const Size *glyphsSize = m_font->getGlyphsSize();
+    int lineHeight = m_font->getGlyphHeight() + m_font->getGlyphSpacing().height();
     int glyph;
 
+    Size textBoxSize(0, m_font->getGlyphHeight());
+    if(!m_textLines.empty())
+        textBoxSize = Size(m_maxLineWidth, m_font->getYOffset() + (m_textLines.size() - 1) * lineHeight + m_font->getGlyphHeight());
+
     // update rect size
     if(!m_rect.isValid() || m_textHorizontalAutoResize || m_textVerticalAutoResize) {
         textBoxSize += Size(m_padding.left + m_padding.right, m_padding.top + m_padding.bottom) + m_textOffset.toSize();
@@ -198,7 +210,7 @@ void UITextEdit::update(bool focusCursor)
                 Rect virtualRect(m_textVirtualOffset, m_rect.size() - Size(m_padding.left+m_padding.right, 0)); // previous rendered virtual rect
                 int pos = m_cursorPos - 1; // element before cursor
                 glyph = (uchar)text[pos]; // glyph of the element before cursor
-                Rect glyphRect(glyphsPositions[pos], glyphsSize[glyph]);
+                Rect glyphRect(getGlyphPosition(pos), glyphsSize[glyph]);
 
                 // if the cursor is not on the previous rendered virtual rect we need to update it
                 if(!virtualRect.contains(glyphRect.topLeft()) || !virtualRect.contains(glyphRect.bottomRight())) {
@@ -207,18 +219,23 @@ void UITextEdit::update(bool focusCursor)
                     startGlyphPos.y = std::max<int>(glyphRect.bottom() - virtualRect.height(), 0);
                     startGlyphPos.x = std::max<int>(glyphRect.right() - virtualRect.width(), 0);
 
-                    // find that glyph
-                    for(pos = 0; pos < textLength; ++pos) {
-                        glyph = (uchar)text[pos];
-                        glyphRect = Rect(glyphsPositions[pos], glyphsSize[glyph]);
-                        glyphRect.setTop(std::max<int>(glyphRect.top() - m_font->getYOffset() - m_font->getGlyphSpacing().height(), 0));
-                        glyphRect.setLeft(std::max<int>(glyphRect.left() - m_font->getGlyphSpacing().width(), 0));
-
-                        // first glyph entirely visible found
-                        if(glyphRect.topLeft().x >= startGlyphPos.x && glyphRect.topLeft().y >= startGlyphPos.y) {
-                            m_textVirtualOffset.x = glyphsPositions[pos].x;
-                            m_textVirtualOffset.y = glyphsPositions[pos].y - m_font->getYOffset();
-                            break;
+                    // find that glyph, skipping the lines above it
+                    bool found = false;
+                    for(int line = 0; line < (int)m_textLines.size() && !found; ++line) {
+                        if(std::max<int>(line * lineHeight - m_font->getGlyphSpacing().height(), 0) < startGlyphPos.y)
+                            continue;
+
+                        int lineEnd = line + 1 < (int)m_textLines.size() ? m_textLines[line + 1].start : textLength;
+                        for(pos = m_textLines[line].start; pos < lineEnd; ++pos) {
+                            Point glyphPos = getGlyphPosition(pos);
+
+                            // first glyph entirely visible found
+                            if(std::max<int>(glyphPos.x - m_font->getGlyphSpacing().width(), 0) >= startGlyphPos.x) {
+                                m_textVirtualOffset.x = glyphPos.x;
+                                m_textVirtualOffset.y = glyphPos.y - m_font->getYOffset();
+                                found = true;
+                                break;
+                            }
                         }
                     }
                 }
@@ -231,7 +248,7 @@ void UITextEdit::update(bool focusCursor)
             Rect virtualRect(m_textVirtualOffset, m_rect.size() - Size(2*m_padding.left+m_padding.right, 0) ); // previous rendered virtual rect
             int pos = m_cursorPos - 1; // element before cursor
             glyph = (uchar)text[pos]; // glyph of the element before cursor
-            Rect glyphRect(glyphsPositions[pos], glyphsSize[glyph]);
+            Rect glyphRect(getGlyphPosition(pos), glyphsSize[glyph]);
             if(virtualRect.contains(glyphRect.topLeft()) && virtualRect.contains(glyphRect.bottomRight()))
                 m_cursorInRange = true;
         } else {
@@ -265,49 +282,51 @@ void UITextEdit::update(bool focusCursor)
         fireAreaUpdate = true;
     }
 
+    Point alignOffset;
     if(m_textAlign & Fw::AlignBottom) {
-        m_drawArea.translate(0, textScreenCoords.height() - textBoxSize.height());
+        alignOffset.y = textScreenCoords.height() - textBoxSize.height();
     } else if(m_textAlign & Fw::AlignVerticalCenter) {
-        m_drawArea.translate(0, (textScreenCoords.height() - textBoxSize.height()) / 2);
+        alignOffset.y = (textScreenCoords.height() - textBoxSize.height()) / 2;
     } else { // AlignTop
     }
 
     if(m_textAlign & Fw::AlignRight) {
-        m_drawArea.translate(textScreenCoords.width() - textBoxSize.width(), 0);
+        alignOffset.x = textScreenCoords.width() - textBoxSize.width();
     } else if(m_textAlign & Fw::AlignHorizontalCenter) {
-        m_drawArea.translate((textScreenCoords.width() - textBoxSize.width()) / 2, 0);
+        alignOffset.x = (textScreenCoords.width() - textBoxSize.width()) / 2;
     } else { // AlignLeft
+    }
+    m_drawArea.translate(alignOffset);
 
+    // glyphs outside the previous visible lines were never set
+    for(int i = m_visibleGlyphStart, end = std::min<int>(m_visibleGlyphEnd, textLength); i < end; ++i)
+        m_glyphsCoords[i].clear();
+    m_visibleGlyphStart = m_visibleGlyphEnd = 0;
+
+    // only the lines that may intersect the visible area are mapped to screen
+    if(!m_textLines.empty()) {
+        int linesTop = alignOffset.y + m_font->getYOffset();
+        int firstLine = std::max<int>((m_textVirtualOffset.y - linesTop - m_font->getGlyphHeight()) / lineHeight, 0);
+        int lastLine = std::min<int>((m_textVirtualOffset.y + textScreenCoords.height() - linesTop) / lineHeight + 1, m_textLines.size() - 1);
+        if(firstLine <= lastLine) {
+            m_visibleGlyphStart = m_textLines[firstLine].start;
+            m_visibleGlyphEnd = lastLine + 1 < (int)m_textLines.size() ? m_textLines[lastLine + 1].start : textLength;
+        }
     }
 
-    for(int i = 0; i < textLength; ++i) {
+    for(int i = m_visibleGlyphStart; i < m_visibleGlyphEnd; ++i) {
         glyph = (uchar)text[i];
-        m_glyphsCoords[i].clear();
 
         // skip invalid glyphs
         if(glyph < 32)
             continue;
 
         // calculate initial glyph rect and texture coords
-        Rect glyphScreenCoords(glyphsPositions[i], glyphsSize[glyph]);
+        Rect glyphScreenCoords(getGlyphPosition(i), glyphsSize[glyph]);
         Rect glyphTextureCoords = glyphsTextureCoords[glyph];
 
         // first translate to align position
-        if(m_textAlign & Fw::AlignBottom) {
-            glyphScreenCoords.translate(0, textScreenCoords.height() - textBoxSize.height());
-        } else if(m_textAlign & Fw::AlignVerticalCenter) {
-            glyphScreenCoords.translate(0, (textScreenCoords.height() - textBoxSize.height()) / 2);
-        } else { // AlignTop
-            // nothing to do
-        }
-
-        if(m_textAlign & Fw::AlignRight) {
-            glyphScreenCoords.translate(textScreenCoords.width() - textBoxSize.width(), 0);
-        } else if(m_textAlign & Fw::AlignHorizontalCenter) {
-            glyphScreenCoords.translate((textScreenCoords.width() - textBoxSize.width()) / 2, 0);
-        } else { // AlignLeft
-            // nothing to do
-        }
+        glyphScreenCoords.translate(alignOffset);
 
         // only render glyphs that are after startRenderPosition
         if(glyphScreenCoords.bottom() < m_textVirtualOffset.y || glyphScreenCoords.right() < m_textVirtualOffset.x)
@@ -352,6 +371,118 @@ void UITextEdit::update(bool focusCursor)
         onTextAreaUpdate(m_textVirtualOffset, m_textVirtualSize, m_textTotalSize);
 }
 
+void UITextEdit::updateTextLayout(const std::string& text)
+{
+    // glyphs sizes belong to the font, so a new font invalidates every line
+    if(m_layoutFont != m_font) {
+        m_layoutFont = m_font;
+        m_layoutText.clear();
+        m_textLines.clear();
+        m_glyphsX.clear();
+    }
+
+    int oldLength = m_layoutText.length();
+    int newLength = text.length();
+    int minLength = std::min<int>(oldLength, newLength);
+
+    // find the changed range, everything before and after it keeps its layout
+    int prefix = 0;
+    while(prefix < minLength && m_layoutText[prefix] == text[prefix])
+        ++prefix;
+    if(prefix == oldLength && prefix == newLength)
+        return;
+
+    int suffix = 0;
+    while(suffix < minLength - prefix && m_layoutText[oldLength - 1 - suffix] == text[newLength - 1 - suffix])
+        ++suffix;
+
+    int delta = newLength - oldLength;
+
+    // the line before the change is included because its last glyph spacing depends on the next glyph
+    auto lineStartLess = [](int pos, const TextLine& line) { return pos < line.start; };
+    int firstLine = 0;
+    if(!m_textLines.empty()) {
+        firstLine = std::upper_bound(m_textLines.begin(), m_textLines.end(), std::max<int>(prefix - 1, 0), lineStartLess) - m_textLines.begin() - 1;
+        if(firstLine <= 0 || m_textLines[firstLine].start == 0)
+            firstLine = 0;
+    }
+    // lines starting after the change are only shifted
+    int endLine = std::lower_bound(m_textLines.begin(), m_textLines.end(), std::max<int>(oldLength - suffix, 1),
+                                   [](const TextLine& line, int pos) { return line.start < pos; }) - m_textLines.begin();
+    endLine = std::max<int>(endLine, firstLine);
+
+    int oldStart = firstLine < (int)m_textLines.size() ? m_textLines[firstLine].start : 0;
+
+    // a text that now starts with '\n' needs its empty first line laid out again
+    if(oldStart == 0 && endLine < (int)m_textLines.size() && m_textLines[endLine].start + delta == 0)
+        ++endLine;
+
+    int oldEnd = endLine < (int)m_textLines.size() ? m_textLines[endLine].start : oldLength;
+    int newEnd = oldEnd + delta;
+
+    const Size *glyphsSize = m_font->getGlyphsSize();
+    int spacing = m_font->getGlyphSpacing().width();
+
+    std::vector<TextLine> lines;
+    std::vector<int> glyphsX;
+    glyphsX.reserve(newEnd - oldStart);
+    int x = 0;
+    for(int i = oldStart; i < newEnd; ++i) {
+        uchar glyph = (uchar)text[i];
+
+        // new line or first glyph
+        if(glyph == (uchar)'\n' || i == oldStart) {
+            // text starting with a new line has an empty first line
+            if(i == 0 && glyph == (uchar)'\n')
+                lines.push_back(TextLine{0, 0});
+            lines.push_back(TextLine{i, 0});
+            x = 0;
+        }
+
+        glyphsX.push_back(x);
+
+        if(glyph >= 32) {
+            x += glyphsSize[glyph].width() + spacing;
+            lines.back().width += glyphsSize[glyph].width();
+            if(i + 1 != newLength && text[i + 1] != '\n') // only add space if letter is not the last or before a \n.
+                lines.back().width += spacing;
+        }
+    }
+
+    m_glyphsX.erase(m_glyphsX.begin() + oldStart, m_glyphsX.begin() + oldEnd);
+    m_glyphsX.insert(m_glyphsX.begin() + oldStart, glyphsX.begin(), glyphsX.end());
+
+    m_textLines.erase(m_textLines.begin() + firstLine, m_textLines.begin() + endLine);
+    m_textLines.insert(m_textLines.begin() + firstLine, lines.begin(), lines.end());
+    for(int i = firstLine + lines.size(); i < (int)m_textLines.size(); ++i)
+        m_textLines[i].start += delta;
+
+    m_maxLineWidth = 0;
+    for(const TextLine& line : m_textLines)
+        m_maxLineWidth = std::max<int>(m_maxLineWidth, line.width);
+
+    m_layoutText = text;
+}
+
+int UITextEdit::getLineIndex(int pos)
+{
+    auto it = std::upper_bound(m_textLines.begin(), m_textLines.end(), pos, [](int pos, const TextLine& line) { return pos < line.start; });
+    return std::max<int>(it - m_textLines.begin() - 1, 0);
+}
+
+Point UITextEdit::getGlyphPosition(int pos)
+{
+    int index = getLineIndex(pos);
+    const TextLine& line = m_textLines[index];
+
+    Point position(m_glyphsX[pos], m_font->getYOffset() + index * (m_font->getGlyphHeight() + m_font->getGlyphSpacing().height()));
+    if(m_textAlign & Fw::AlignRight)
+        position.x += m_maxLineWidth - line.width;
+    else if(m_textAlign & Fw::AlignHorizontalCenter)
+        position.x += (m_maxLineWidth - line.width) / 2;
+    return position;
+}
+
 void UITextEdit::setCursorPos(int pos)
 {
     if(pos < 0)
@@ -596,7 +727,7 @@ int UITextEdit::getTextPos(Point pos)
     // find any glyph that is actually on the
     int candidatePos = -1;
     Rect firstGlyphRect, lastGlyphRect;
-    for(int i=0;i<textLength;++i) {
+    for(int i = m_visibleGlyphStart, end = std::min<int>(m_visibleGlyphEnd, m_glyphsCoords.size()); i < end; ++i) {
         Rect clickGlyphRect = m_glyphsCoords[i];
         if(!clickGlyphRect.isValid())
             continue;
@@ -35,6 +35,9 @@ public:
 
 private:
     void update(bool focusCursor = false);
+    void updateTextLayout(const std::string& text);
+    int getLineIndex(int pos);
+    Point getGlyphPosition(int pos);
 
 public:
     void setCursorPos(int pos);
@@ -113,6 +116,12 @@ private:
     void enableUpdates() { m_updatesEnabled = true; }
     void recacheGlyphs() { m_glyphsMustRecache = true; }
 
+    // a line starts at its '\n' glyph, glyphs positions are kept relative to the line
+    struct TextLine {
+        int start;
+        int width;
+    };
+
     Rect m_drawArea;
     int m_cursorPos;
     Point m_textVirtualOffset;
@@ -146,6 +155,14 @@ private:
     CoordsBuffer m_glyphsSelectCoordsBuffer;
     bool m_glyphsMustRecache;
 
+    std::string m_layoutText;
+    BitmapFontPtr m_layoutFont;
+    std::vector<TextLine> m_textLines;
+    std::vector<int> m_glyphsX;
+    int m_maxLineWidth;
+    int m_visibleGlyphStart;
+    int m_visibleGlyphEnd;
+
     std::string m_placeholder;
     Color m_placeholderColor;
     Fw::AlignmentFlag m_placeholderAlign;
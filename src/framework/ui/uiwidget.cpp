@@ -586,6 +586,13 @@ void UIWidget::mergeStyle(const OTMLNodePtr& styleNode)
     m_style->merge(styleNode);
     m_style->setTag(name);
     m_style->setSource(source);
+    for(const OTMLNodePtr& node : styleNode->children()) {
+        if(stdext::starts_with(node->tag(), "$")) {
+            m_styleOrigin = nullptr;
+            break;
+        }
+    }
+    m_stateStylesDirty = true;
     updateStyle();
 }
 
@@ -989,16 +996,20 @@ void UIWidget::setStyle(const std::string& styleName)
         g_logger.traceError(stdext::format("unable to retrieve style '%s': not a defined style", styleName));
         return;
     }
-    styleNode = styleNode->clone();
-    applyStyle(styleNode);
-    m_style = styleNode;
-    updateStyle();
+    setStyleNode(styleNode->clone(), styleNode);
 }
 
 void UIWidget::setStyleFromNode(const OTMLNodePtr& styleNode)
+{
+    setStyleNode(styleNode, nullptr);
+}
+
+void UIWidget::setStyleNode(const OTMLNodePtr& styleNode, const OTMLNodePtr& origin)
 {
     applyStyle(styleNode);
     m_style = styleNode;
+    m_styleOrigin = origin;
+    m_stateStylesDirty = true;
     updateStyle();
 }
 
@@ -1504,47 +1515,114 @@ void UIWidget::updateStyle()
     if(!m_style)
         return;
 
-    OTMLNodePtr newStateStyle = OTMLNode::create();
+    // a new base style was applied, so every state property must be set again
+    bool fullApply = m_stateStylesDirty;
+    if(m_stateStylesDirty)
+        compileStateStyles();
+
+    // merged state styles are cached by the combination of states the selectors look at
+    int statesKey = m_states & m_stateStyles->mask;
+    OTMLNodePtr mergedStyle;
+    auto it = m_stateStyles->merged.find(statesKey);
+    if(it != m_stateStyles->merged.end()) {
+        mergedStyle = it->second;
+    } else {
+        mergedStyle = OTMLNode::create();
+        for(const UIStateStyles::StateStyle& stateStyle : m_stateStyles->styles) {
+            if((m_states & stateStyle.requiredStates) == stateStyle.requiredStates && !(m_states & stateStyle.forbiddenStates))
+                mergedStyle->merge(stateStyle.node);
+        }
+        m_stateStyles->merged[statesKey] = mergedStyle;
+    }
+
+    OTMLNodePtr newStateStyle = OTMLNode::create(mergedStyle->tag());
 
-    // copy only the changed styles from default style
+    // restore from default style the properties no longer set by any state
     if(m_stateStyle) {
-        for(OTMLNodePtr node : m_stateStyle->children()) {
-            if(OTMLNodePtr otherNode = m_style->get(node->tag()))
+        std::set<std::string> mergedTags;
+        for(const OTMLNodePtr& node : mergedStyle->children())
+            mergedTags.insert(node->tag()[0] == '!' ? node->tag().substr(1) : node->tag());
+
+        for(const OTMLNodePtr& node : m_stateStyle->children()) {
+            std::string tag = node->tag();
+            if(tag[0] == '!')
+                tag = tag.substr(1);
+            if(mergedTags.count(tag))
+                continue;
+            if(OTMLNodePtr otherNode = m_style->get(tag))
                 newStateStyle->addChild(otherNode->clone());
         }
     }
 
-    // checks for states combination
-    for(const OTMLNodePtr& style : m_style->children()) {
-        if(stdext::starts_with(style->tag(), "$")) {
-            std::string statesStr = style->tag().substr(1);
-            std::vector<std::string> statesSplit = stdext::split(statesStr, " ");
+    // set only the properties that changed, dynamic ! properties are always evaluated again
+    for(const OTMLNodePtr& node : mergedStyle->children()) {
+        if(!fullApply && m_stateStyle && node->tag()[0] != '!' && !node->hasChildren()) {
+            OTMLNodePtr oldNode = m_stateStyle->get(node->tag());
+            if(oldNode && !oldNode->hasChildren() && oldNode->rawValue() == node->rawValue())
+                continue;
+        }
+        newStateStyle->addChild(node->clone());
+    }
+
+    // cached nodes are kept untouched, applyStyle translates ! tags in place
+    applyStyle(newStateStyle);
+    m_stateStyle = mergedStyle;
+}
+
+void UIWidget::compileStateStyles()
+{
+    m_stateStylesDirty = false;
 
-            bool match = true;
-            for(std::string stateStr : statesSplit) {
-                if(stateStr.length() == 0)
-                    continue;
+    // widgets styled from the same registered style share what was compiled for it
+    if(m_styleOrigin) {
+        m_stateStyles = g_ui.getStateStyles(m_styleOrigin);
+        return;
+    }
 
-                bool notstate = (stateStr[0] == '!');
-                if(notstate)
-                    stateStr = stateStr.substr(1);
+    m_stateStyles = std::make_shared<UIStateStyles>();
+    m_stateStyles->compile(m_style);
+}
 
-                bool stateOn = hasState(Fw::translateState(stateStr));
-                if((!notstate && !stateOn) || (notstate && stateOn))
-                    match = false;
-            }
+void UIStateStyles::compile(const OTMLNodePtr& style)
+{
+    for(const OTMLNodePtr& node : style->children()) {
+        if(!stdext::starts_with(node->tag(), "$"))
+            continue;
 
-            // merge states styles
-            if(match) {
-                newStateStyle->merge(style);
+        StateStyle stateStyle;
+        stateStyle.requiredStates = 0;
+        stateStyle.forbiddenStates = 0;
+        stateStyle.node = node;
+
+        bool valid = true;
+        for(std::string stateStr : stdext::split(node->tag().substr(1), " ")) {
+            if(stateStr.length() == 0)
+                continue;
+
+            bool notstate = (stateStr[0] == '!');
+            if(notstate)
+                stateStr = stateStr.substr(1);
+
+            Fw::WidgetState state = Fw::translateState(stateStr);
+            if(state == Fw::InvalidState) {
+                // an unknown state is never on
+                if(!notstate)
+                    valid = false;
+                continue;
             }
+
+            if(notstate)
+                stateStyle.forbiddenStates |= state;
+            else
+                stateStyle.requiredStates |= state;
         }
-    }
 
-    //TODO: prevent setting already set proprieties
+        if(!valid)
+            continue;
 
-    applyStyle(newStateStyle);
-    m_stateStyle = newStateStyle;
+        mask |= stateStyle.requiredStates | stateStyle.forbiddenStates;
+        styles.push_back(stateStyle);
+    }
 }
 
 void UIWidget::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
@@ -33,6 +33,22 @@
 #include <framework/graphics/coordsbuffer.h>
 #include <framework/core/timer.h>
 
+// the "$state !state" selectors of a style compiled into state bitmasks, shared by the widgets of the style
+struct UIStateStyles {
+    struct StateStyle {
+        int requiredStates;
+        int forbiddenStates;
+        OTMLNodePtr node;
+    };
+
+    void compile(const OTMLNodePtr& style);
+
+    int mask = 0;
+    std::vector<StateStyle> styles;
+    // merged state styles by the combination of states the selectors look at
+    std::unordered_map<int, OTMLNodePtr> merged;
+};
+
 template<typename T = int>
 struct EdgeGroup {
     EdgeGroup() { top = right = bottom = left = T(0); }
@@ -179,11 +195,17 @@ private:
     void updateStates();
     void updateChildrenIndexStates();
     void updateStyle();
+    void compileStateStyles();
+    void setStyleNode(const OTMLNodePtr& styleNode, const OTMLNodePtr& origin);
 
     stdext::boolean<false> m_updateStyleScheduled;
     stdext::boolean<true> m_firstOnStyle;
+    stdext::boolean<true> m_stateStylesDirty;
     OTMLNodePtr m_stateStyle;
     int m_states;
+    // registered style m_style was cloned from while their state selectors are the same, null otherwise
+    OTMLNodePtr m_styleOrigin;
+    UIStateStylesPtr m_stateStyles;
 
 
 // event processing
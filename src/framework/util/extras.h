@@ -19,6 +19,7 @@ public:
         DEFINE_OPTION(debugPredictiveWalking, "Debug predictive walking");
         DEFINE_OPTION(debugPathfinding, "Debug path finding");
         DEFINE_OPTION(debugRender, "Debug render");
+        DEFINE_OPTION(debugOcclusion, "Debug floor occlusion");
         DEFINE_OPTION(debugProxy, "Debug proxy");
         DEFINE_OPTION(showPredictions, "Show predictions");
         DEFINE_OPTION(debugWidgets, "Debug widgets");
@@ -35,6 +36,7 @@ public:
     bool debugPredictiveWalking = false;
     bool debugPathfinding  = false;
     bool debugRender = false;
+    bool debugOcclusion = false;
     bool debugProxy = false;
     bool disablePredictiveWalking = false;
     bool showPredictions = false;
@@ -96,6 +96,13 @@ int main(int argc, const char* argv[]) {
         }
     }
 
+    bool benchmarkMode = std::find(args.begin(), args.end(), "--benchmark") != args.end();
+    if (benchmarkMode) {
+        if (!g_lua.safeRunScript("benchmark.lua")) {
+            g_logger.fatal("Can't run benchmark.lua");
+        }
+    }
+
 #ifdef WIN32
     // support for progdn proxy system, if you don't have this dll nothing will happen
     // however, it is highly recommended to use otcv8 proxy system